@@ -0,0 +1,512 @@
+#include "Analyzer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace Analyzer
+{
+	namespace
+	{
+		constexpr double INF = std::numeric_limits<double>::infinity();
+
+		// Events that a launched projectile fires by itself during its life
+		constexpr const char* LIFE_EVENTS[] = { "ProjImpact", "ProjDestroyed", "HitProjectile", "HitByProjectile",
+			"ImpactBurst" };
+
+		double mul(double k, double val) { return k == 0 || val == 0 ? 0 : k * val; }
+
+		Cost operator+(const Cost& a, const Cost& b) { return { a.projectiles + b.projectiles, a.set_homing + b.set_homing }; }
+		Cost operator*(double k, const Cost& a) { return { mul(k, a.projectiles), mul(k, a.set_homing) }; }
+
+		std::string num(double val)
+		{
+			if (std::isinf(val))
+				return "unbounded";
+
+			char buf[32];
+			std::snprintf(buf, sizeof(buf), val == std::floor(val) ? "%.0f" : "%.2f", val);
+			return buf;
+		}
+
+		struct Function
+		{
+			std::string type;
+			std::string id;  // full name of referenced data
+			bool on_followers;
+		};
+		using Functions = std::vector<Function>;
+
+		struct Condition
+		{
+			std::string type;
+			std::string form;
+		};
+
+		struct Trigger
+		{
+			std::string name;
+			std::string event;
+			std::vector<Condition> conditions;
+			Functions functions;
+		};
+
+		struct MulticastItem
+		{
+			std::string spell;  // "Current" or empty if unknown
+			uint32_t count;
+			bool call_triggers;
+			Functions functions;
+		};
+
+		struct Emitter
+		{
+			float interval;
+			bool limited;
+			uint32_t count;
+			std::vector<Functions> functions;
+		};
+
+		// Forms known at some point of a chain, empty if unknown.
+		// Only these two conditions are checked, others are assumed to pass.
+		struct Context
+		{
+			std::string spell;
+			std::string proj;
+		};
+
+		class Graph
+		{
+		public:
+			Graph(const Files& files, const Settings& settings) : settings(settings)
+			{
+				for (const auto& [filename, json_root] : files) {
+					read_formids(filename, json_root);
+					read(filename, json_root);
+				}
+			}
+
+			Report run()
+			{
+				Report ans;
+				ans.multicasts = static_cast<uint32_t>(multicasts.size());
+
+				for (const auto& [event, event_triggers] : triggers) {
+					for (const auto& trigger : event_triggers) {
+						auto cost = get_cost(trigger, {});
+						ans.triggers.push_back({ trigger.name, cost });
+						ans.worst.projectiles = std::max(ans.worst.projectiles, cost.projectiles);
+						ans.worst.set_homing = std::max(ans.worst.set_homing, cost.set_homing);
+					}
+				}
+
+				for (const auto& [name, emitter] : emitters) {
+					Cost tick;
+					for (const auto& functions : emitter.functions) {
+						tick = tick + get_cost(functions, {});
+					}
+					ans.emitters.push_back({ name, emitter.interval, get_ticks(emitter), tick });
+				}
+
+				ans.cycles.assign(cycles.begin(), cycles.end());
+				return ans;
+			}
+
+		private:
+			std::string form(const std::string& filename, const std::string& name) const
+			{
+				if (name.starts_with("key_")) {
+					auto found = formids.find(filename + name);
+					return found == formids.end() ? name : found->second;
+				}
+				return name;
+			}
+
+			void read_formids(const std::string& filename, const Json::Value& json_root)
+			{
+				if (!json_root.isMember("FormIDs"))
+					return;
+
+				const auto& json_formids = json_root["FormIDs"];
+				for (const auto& key : json_formids.getMemberNames()) {
+					formids.insert({ filename + key, json_formids[key].asString() });
+				}
+			}
+
+			static uint32_t get_count(const Json::Value& json_pattern)
+			{
+				const auto& figure = json_pattern["Figure"];
+				return figure.isMember("count") ? figure["count"].asUInt() : 1;
+			}
+
+			Functions read_functions(const std::string& filename, const Json::Value& json_TriggerFunctions) const
+			{
+				Functions ans;
+				for (const auto& json_function : json_TriggerFunctions["functions"]) {
+					auto type = json_function["type"].asString();
+					std::string id;
+					if (type == "ApplyMultiCast")
+						id = filename + "/MulticastData/" + json_function["id"].asString();
+					else if (type == "SetEmitter")
+						id = filename + "/EmittersData/" + json_function["id"].asString();
+
+					ans.push_back({ type, id, json_function.get("on_followers", false).asBool() });
+				}
+				return ans;
+			}
+
+			void read(const std::string& filename, const Json::Value& json_root)
+			{
+				std::unordered_map<std::string, uint32_t> spawn_groups;
+				for (const auto& key : json_root["MulticastSpawnGroups"].getMemberNames()) {
+					spawn_groups.insert({ key, get_count(json_root["MulticastSpawnGroups"][key]["Pattern"]) });
+				}
+
+				const auto& json_multicasts = json_root["MulticastData"];
+				for (const auto& key : json_multicasts.getMemberNames()) {
+					auto& items = multicasts[filename + "/MulticastData/" + key];
+					for (const auto& json_item : json_multicasts[key]) {
+						MulticastItem item{};
+						if (json_item.isMember("spellID"))
+							item.spell = form(filename, json_item["spellID"].asString());
+						else if (json_item.get("weapID", "").asString() == "Current")
+							item.spell = "Current";
+
+						auto found = spawn_groups.find(json_item["spawn_group"].asString());
+						item.count = found == spawn_groups.end() ? 1 : found->second;
+						item.call_triggers = json_item.get("callTriggers", false).asBool();
+						if (json_item.isMember("TriggerFunctions"))
+							item.functions = read_functions(filename, json_item["TriggerFunctions"]);
+
+						items.push_back(std::move(item));
+					}
+				}
+
+				const auto& json_emitters = json_root["EmittersData"];
+				for (const auto& key : json_emitters.getMemberNames()) {
+					const auto& json_emitter = json_emitters[key];
+					auto& emitter = emitters[filename + "/EmittersData/" + key];
+					emitter.interval = json_emitter["interval"].asFloat();
+					emitter.limited = json_emitter.get("limited", false).asBool();
+					emitter.count = json_emitter.get("count", 1).asUInt();
+					for (const auto& json_function : json_emitter["functions"]) {
+						if (json_function["type"].asString() == "TriggerFunctions")
+							emitter.functions.push_back(read_functions(filename, json_function["TriggerFunctions"]));
+					}
+				}
+
+				const auto& json_followers = json_root["FollowersData"];
+				for (const auto& key : json_followers.getMemberNames()) {
+					max_followers = std::max(max_followers, get_count(json_followers[key]["Pattern"]));
+				}
+
+				const auto& json_triggers = json_root["Triggers"];
+				for (Json::ArrayIndex i = 0; i < json_triggers.size(); i++) {
+					const auto& json_trigger = json_triggers[i];
+
+					Trigger trigger;
+					trigger.event = json_trigger["event"].asString();
+					trigger.name = filename + "/Triggers[" + std::to_string(i) + "] (" + trigger.event + ")";
+					trigger.functions = read_functions(filename, json_trigger["TriggerFunctions"]);
+
+					// Array of {type, formID}, old configs use {type: formID}
+					const auto& json_conditions = json_trigger["conditions"];
+					if (json_conditions.isArray()) {
+						for (const auto& json_condition : json_conditions) {
+							trigger.conditions.push_back(
+								{ json_condition["type"].asString(), form(filename, json_condition.get("formID", "").asString()) });
+						}
+					} else if (json_conditions.isObject()) {
+						for (const auto& type : json_conditions.getMemberNames()) {
+							trigger.conditions.push_back({ type, form(filename, json_conditions[type].asString()) });
+						}
+					}
+
+					triggers[trigger.event].push_back(std::move(trigger));
+				}
+			}
+
+			double get_ticks(const Emitter& emitter) const
+			{
+				if (emitter.limited)
+					return emitter.count;
+
+				return emitter.interval > 0 ? std::max(1.0, std::floor(static_cast<double>(settings.lifetime / emitter.interval))) : INF;
+			}
+
+			// Memoized DFS, a node met again on the stack is a cycle
+			template <typename F>
+			Cost visit(const std::string& name, const Context& ctx, F compute)
+			{
+				auto key = name + '|' + ctx.spell + '|' + ctx.proj;
+				if (auto found = memo.find(key); found != memo.end())
+					return found->second;
+
+				if (auto found = std::find(stack.begin(), stack.end(), key); found != stack.end()) {
+					add_cycle(static_cast<size_t>(found - stack.begin()));
+					return { INF, INF };
+				}
+
+				stack.push_back(key);
+				stack_names.push_back(name);
+				Cost ans = compute();
+				stack.pop_back();
+				stack_names.pop_back();
+
+				memo.insert({ key, ans });
+				return ans;
+			}
+
+			void add_cycle(size_t from)
+			{
+				std::vector<std::string> cycle(stack_names.begin() + from, stack_names.end());
+				std::rotate(cycle.begin(), std::min_element(cycle.begin(), cycle.end()), cycle.end());
+				cycles.insert(cycle);
+			}
+
+			Cost get_cost(const Trigger& trigger, Context ctx)
+			{
+				for (const auto& condition : trigger.conditions) {
+					std::string* known = nullptr;
+					if (condition.type == "SpellIsFormID")
+						known = &ctx.spell;
+					else if (condition.type == "ProjBaseIsFormID")
+						known = &ctx.proj;
+					else
+						continue;
+
+					if (!known->empty() && *known != condition.form)
+						return {};
+					*known = condition.form;
+				}
+
+				return visit(trigger.name, ctx, [&]() { return get_cost(trigger.functions, ctx); });
+			}
+
+			Cost get_cost(const std::string& event, const Context& ctx)
+			{
+				Cost ans;
+				if (auto found = triggers.find(event); found != triggers.end()) {
+					for (const auto& trigger : found->second) {
+						ans = ans + get_cost(trigger, ctx);
+					}
+				}
+				return ans;
+			}
+
+			Cost get_cost(const Functions& functions, const Context& ctx)
+			{
+				Cost ans;
+				for (const auto& function : functions) {
+					Cost cur;
+					if (function.type == "ApplyMultiCast")
+						cur = get_multicast_cost(function.id, ctx);
+					else if (function.type == "SetEmitter")
+						cur = get_emitter_cost(function.id, ctx);
+					else if (function.type == "SetHoming")
+						cur.set_homing = 1;
+
+					// Every follower of the caster, at least one group of them
+					ans = ans + (function.on_followers ? static_cast<double>(std::max(max_followers, 1u)) : 1.0) * cur;
+				}
+				return ans;
+			}
+
+			Cost get_multicast_cost(const std::string& name, const Context& ctx)
+			{
+				auto found = multicasts.find(name);
+				if (found == multicasts.end())
+					return {};
+
+				return visit(name, ctx, [&]() {
+					Cost ans;
+					for (const auto& item : found->second) {
+						Context new_ctx = item.spell == "Current" ? ctx : Context{ item.spell, "" };
+
+						Cost proj{ 1, 0 };
+						proj = proj + get_cost(item.functions, new_ctx);
+						if (item.call_triggers)
+							proj = proj + get_cost(std::string("ProjAppeared"), new_ctx);
+						for (auto event : LIFE_EVENTS) {
+							proj = proj + get_cost(std::string(event), new_ctx);
+						}
+
+						ans = ans + static_cast<double>(item.count) * proj;
+					}
+					return ans;
+				});
+			}
+
+			Cost get_emitter_cost(const std::string& name, const Context& ctx)
+			{
+				auto found = emitters.find(name);
+				if (found == emitters.end())
+					return {};
+
+				return visit(name, ctx, [&]() {
+					Cost tick;
+					for (const auto& functions : found->second.functions) {
+						tick = tick + get_cost(functions, ctx);
+					}
+					return get_ticks(found->second) * tick;
+				});
+			}
+
+			const Settings& settings;
+
+			std::unordered_map<std::string, std::string> formids;  // filename + key -> form
+			std::map<std::string, std::vector<Trigger>> triggers;  // by event
+			std::map<std::string, std::vector<MulticastItem>> multicasts;
+			std::map<std::string, Emitter> emitters;
+			uint32_t max_followers = 0;
+
+			std::unordered_map<std::string, Cost> memo;
+			std::vector<std::string> stack;
+			std::vector<std::string> stack_names;
+			std::set<std::vector<std::string>> cycles;
+		};
+	}
+
+	Report analyze(const Files& files, const Settings& settings) { return Graph(files, settings).run(); }
+
+	std::vector<std::string> Report::format() const
+	{
+		std::vector<std::string> ans;
+		ans.push_back("Analyzer: " + std::to_string(triggers.size()) + " triggers, " + std::to_string(multicasts) +
+					  " multicasts, " + std::to_string(emitters.size()) + " emitters");
+
+		for (const auto& cycle : cycles) {
+			std::string line = "Cycle: ";
+			for (const auto& name : cycle) {
+				line += name + " -> ";
+			}
+			ans.push_back(line + cycle.front());
+		}
+
+		for (const auto& trigger : triggers) {
+			if (trigger.cost.projectiles > 0 || trigger.cost.set_homing > 0)
+				ans.push_back("Trigger " + trigger.name + ": up to " + num(trigger.cost.projectiles) + " projectiles, " +
+							  num(trigger.cost.set_homing) + " SetHoming calls");
+		}
+
+		for (const auto& emitter : emitters) {
+			double rate = emitter.interval > 0 ? 1 / emitter.interval : INF;
+			ans.push_back("Emitter " + emitter.name + ": " + num(rate) + " ticks/s, " + num(emitter.ticks) + " ticks, " +
+						  num(emitter.tick.projectiles) + " projectiles per tick (" + num(mul(rate, emitter.tick.projectiles)) +
+						  "/s)");
+		}
+
+		ans.push_back("Worst cast: up to " + num(worst.projectiles) + " projectiles, " + num(worst.set_homing) +
+					  " SetHoming calls");
+		return ans;
+	}
+
+	Usage get_usage(const Files& files)
+	{
+		Usage ans;
+
+		auto add_functions = [&ans](const Json::Value& json_TriggerFunctions) {
+			for (const auto& json_function : json_TriggerFunctions["functions"]) {
+				ans.functions.insert(json_function["type"].asString());
+			}
+		};
+
+		for (const auto& [filename, json_root] : files) {
+			ans.homing = ans.homing || !json_root["HomingData"].empty();
+			ans.emitters = ans.emitters || !json_root["EmittersData"].empty();
+			ans.followers = ans.followers || !json_root["FollowersData"].empty();
+
+			const auto& json_multicasts = json_root["MulticastData"];
+			for (const auto& key : json_multicasts.getMemberNames()) {
+				for (const auto& json_item : json_multicasts[key]) {
+					add_functions(json_item["TriggerFunctions"]);
+				}
+			}
+
+			const auto& json_emitters = json_root["EmittersData"];
+			for (const auto& key : json_emitters.getMemberNames()) {
+				for (const auto& json_function : json_emitters[key]["functions"]) {
+					add_functions(json_function["TriggerFunctions"]);
+				}
+			}
+
+			for (const auto& json_trigger : json_root["Triggers"]) {
+				ans.events.insert(json_trigger["event"].asString());
+				add_functions(json_trigger["TriggerFunctions"]);
+
+				const auto& json_conditions = json_trigger["conditions"];
+				if (json_conditions.isArray()) {
+					for (const auto& json_condition : json_conditions) {
+						ans.conditions.insert(json_condition["type"].asString());
+					}
+				} else if (json_conditions.isObject()) {
+					for (const auto& type : json_conditions.getMemberNames()) {
+						ans.conditions.insert(type);
+					}
+				}
+			}
+		}
+
+		return ans;
+	}
+
+	const char* get_name(HookGroup group)
+	{
+		constexpr const char* NAMES[] = { "Homing", "Followers", "Emitters", "ApplyGravity", "Kill", "Launch", "Melee",
+			"Effects", "Impacts", "PreInit" };
+		static_assert(std::size(NAMES) == static_cast<size_t>(HookGroup::Total));
+
+		return group < HookGroup::Total ? NAMES[static_cast<size_t>(group)] : "";
+	}
+
+	std::vector<HookGroup> get_hook_groups(const Usage& usage)
+	{
+		auto any_of = [](const std::set<std::string>& used, std::initializer_list<const char*> names) {
+			return std::any_of(names.begin(), names.end(), [&used](const char* name) { return used.contains(name); });
+		};
+
+		bool needs[static_cast<size_t>(HookGroup::Total)] = {};
+		auto need = [&needs](HookGroup group) { needs[static_cast<size_t>(group)] = true; };
+
+		if (usage.homing) {
+			need(HookGroup::Homing);
+			need(HookGroup::ApplyGravity);
+			need(HookGroup::Kill);
+		}
+		if (usage.followers) {
+			need(HookGroup::Followers);
+			need(HookGroup::ApplyGravity);
+			need(HookGroup::Kill);
+		}
+		if (usage.emitters) {
+			need(HookGroup::Emitters);
+			need(HookGroup::Kill);
+		}
+
+		// Multicasts write cascade records, Kill frees them
+		if (usage.events.contains("ProjDestroyed") || usage.functions.contains("ApplyMultiCast"))
+			need(HookGroup::Kill);
+		if (usage.events.contains("ProjAppeared"))
+			need(HookGroup::Launch);
+		if (any_of(usage.events, { "Swing", "HitMelee", "HitByMelee" }))
+			need(HookGroup::Melee);
+		// Effects also keep the keywords cache of casters up to date
+		if (any_of(usage.events, { "EffectStart", "EffectEnd" }) || usage.conditions.contains("CasterHasKwd"))
+			need(HookGroup::Effects);
+		if (any_of(usage.events, { "ProjImpact", "HitProjectile", "HitByProjectile", "ImpactBurst" }))
+			need(HookGroup::Impacts);
+		if (any_of(usage.functions, { "ChangeSpeed", "SetColLayer" }))
+			need(HookGroup::PreInit);
+
+		std::vector<HookGroup> ans;
+		for (size_t i = 0; i < std::size(needs); i++) {
+			if (needs[i])
+				ans.push_back(static_cast<HookGroup>(i));
+		}
+		return ans;
+	}
+}
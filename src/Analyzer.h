@@ -0,0 +1,87 @@
+#pragma once
+
+#include "json/json.h"
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Static analysis of configs: which events lead to which multicasts, emitters and triggers,
+// and how many projectiles one cast may end up with. Does not use the game, tools/analyzer runs it too.
+namespace Analyzer
+{
+	struct Settings
+	{
+		float lifetime = 10.0f;  // how long an unlimited emitter works, seconds
+	};
+
+	struct Cost
+	{
+		double projectiles = 0;  // launched by multicasts, infinity if unbounded
+		double set_homing = 0;   // SetHoming calls, projectiles made homing
+	};
+
+	struct Report
+	{
+		struct Trigger
+		{
+			std::string name;
+			Cost cost;  // of one call
+		};
+
+		struct Emitter
+		{
+			std::string name;
+			float interval;
+			double ticks;  // during life of a projectile
+			Cost tick;     // of one tick
+		};
+
+		uint32_t multicasts = 0;
+		std::vector<std::vector<std::string>> cycles;
+		std::vector<Trigger> triggers;
+		std::vector<Emitter> emitters;
+		Cost worst;  // of any trigger
+
+		std::vector<std::string> format() const;
+	};
+
+	using Files = std::vector<std::pair<std::string, Json::Value>>;  // filename, parsed json
+
+	Report analyze(const Files& files, const Settings& settings = {});
+
+	// Features, events, conditions and functions that configs use
+	struct Usage
+	{
+		bool homing = false;
+		bool emitters = false;
+		bool followers = false;
+		std::set<std::string> events;
+		std::set<std::string> conditions;
+		std::set<std::string> functions;
+	};
+
+	Usage get_usage(const Files& files);
+
+	// Hooks are installed by groups, only groups that some config needs
+	enum class HookGroup : uint32_t
+	{
+		Homing,        // homing flames
+		Followers,     // follower points and collisions
+		Emitters,      // emitter impacts
+		ApplyGravity,  // shared by homing and followers
+		Kill,          // ProjDestroyed, features and multicast cascades forget the projectile
+		Launch,        // ProjAppeared
+		Melee,         // Swing, HitMelee, HitByMelee
+		Effects,       // EffectStart, EffectEnd, keywords of casters
+		Impacts,       // ProjImpact, HitProjectile, HitByProjectile, ImpactBurst
+		PreInit,       // ChangeSpeed and SetColLayer of not inited projectiles
+
+		Total
+	};
+
+	const char* get_name(HookGroup group);
+
+	// In the order of HookGroup
+	std::vector<HookGroup> get_hook_groups(const Usage& usage);
+}
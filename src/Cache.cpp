@@ -0,0 +1,231 @@
+#include "Cache.h"
+
+namespace Cache
+{
+	namespace Keywords
+	{
+		struct Storage
+		{
+			static uint32_t add(RE::FormID formid)
+			{
+				if (auto found = bits.find(formid); found != bits.end())
+					return found->second;
+
+				auto kwd = RE::TESForm::LookupByID<RE::BGSKeyword>(formid);
+				if (!kwd)
+					logger::error("Keyword {:X} not found", formid);
+
+				uint32_t bit = static_cast<uint32_t>(keywords.size());
+				keywords.push_back(kwd);
+				bits.insert({ formid, bit });
+				return bit;
+			}
+
+			static bool caster_has(RE::Actor* caster, uint32_t bit)
+			{
+				std::lock_guard lock(actors_lock);
+
+				auto found = actors.find(caster->formID);
+				if (found == actors.end()) {
+					found = actors.insert({ caster->formID, build(caster) }).first;
+				}
+				return found->second.test(bit);
+			}
+
+			static void invalidate(RE::TESObjectREFR* refr)
+			{
+				if (keywords.empty())
+					return;
+
+				std::lock_guard lock(actors_lock);
+				actors.erase(refr->formID);
+			}
+
+			static void reset()
+			{
+				std::lock_guard lock(actors_lock);
+				actors.clear();
+			}
+
+			static void clear()
+			{
+				reset();
+				keywords.clear();
+				bits.clear();
+			}
+
+		private:
+			static Bits build(RE::Actor* caster)
+			{
+				Bits ans;
+				ans.resize(static_cast<uint32_t>(keywords.size()));
+
+				auto base = caster->GetActorBase();
+				for (uint32_t i = 0; i < keywords.size(); i++) {
+					if (auto kwd = keywords[i]) {
+						if (caster->HasKeyword(kwd) || (base && base->HasKeyword(kwd)) ||
+							FenixUtils::TESObjectREFR__HasEffectKeyword(caster, kwd)) {
+							ans.set(i);
+						}
+					}
+				}
+				return ans;
+			}
+
+			static inline std::vector<RE::BGSKeyword*> keywords;
+			static inline std::unordered_map<RE::FormID, uint32_t> bits;
+
+			static inline std::mutex actors_lock;
+			static inline std::unordered_map<RE::FormID, Bits> actors;
+		};
+
+		uint32_t add(RE::FormID formid) { return Storage::add(formid); }
+		bool caster_has(RE::Actor* caster, uint32_t bit) { return Storage::caster_has(caster, bit); }
+		void invalidate(RE::TESObjectREFR* refr) { Storage::invalidate(refr); }
+
+		// Equipped items may add keywords to the actor
+		class EquipHandler : public RE::BSTEventSink<RE::TESEquipEvent>
+		{
+		public:
+			static EquipHandler* GetSingleton()
+			{
+				static EquipHandler singleton;
+				return std::addressof(singleton);
+			}
+
+			RE::BSEventNotifyControl ProcessEvent(const RE::TESEquipEvent* e, RE::BSTEventSource<RE::TESEquipEvent>*) override
+			{
+				if (e && e->actor) {
+					invalidate(e->actor.get());
+				}
+				return RE::BSEventNotifyControl::kContinue;
+			}
+
+			void enable()
+			{
+				if (auto holder = RE::ScriptEventSourceHolder::GetSingleton()) {
+					holder->AddEventSink<RE::TESEquipEvent>(this);
+				}
+			}
+		};
+	}
+
+	namespace Spells
+	{
+		// Maps formID -> bit
+		class FormBits
+		{
+			std::unordered_map<RE::FormID, uint32_t> bits;
+
+		public:
+			uint32_t add(RE::FormID formid)
+			{
+				auto new_bit = static_cast<uint32_t>(bits.size());
+				return bits.insert({ formid, new_bit }).first->second;
+			}
+
+			const uint32_t* find(RE::FormID formid) const
+			{
+				auto found = bits.find(formid);
+				return found == bits.end() ? nullptr : &found->second;
+			}
+
+			uint32_t size() const { return static_cast<uint32_t>(bits.size()); }
+			bool empty() const { return bits.empty(); }
+			void clear() { bits.clear(); }
+		};
+
+		// Spells never change, so it is built once per spell
+		struct Signature
+		{
+			RE::FormID formid;  // pointer may be reused by another spell
+			Bits kwds;
+			Bits effects;
+		};
+
+		struct Storage
+		{
+			static uint32_t add_effect_kwd(RE::FormID formid) { return kwds.add(formid); }
+			static uint32_t add_effect(RE::FormID formid) { return effects.add(formid); }
+
+			static const Signature& get(RE::MagicItem* spel)
+			{
+				auto found = signatures.find(spel);
+				if (found == signatures.end()) {
+					found = signatures.insert({ spel, build(spel) }).first;
+				} else if (found->second.formid != spel->formID) {
+					found->second = build(spel);
+				}
+				return found->second;
+			}
+
+			static bool has_effect_kwd(RE::MagicItem* spel, uint32_t bit)
+			{
+				std::lock_guard lock(signatures_lock);
+				return get(spel).kwds.test(bit);
+			}
+
+			static bool has_effect(RE::MagicItem* spel, uint32_t bit)
+			{
+				std::lock_guard lock(signatures_lock);
+				return get(spel).effects.test(bit);
+			}
+
+			static void clear()
+			{
+				std::lock_guard lock(signatures_lock);
+				signatures.clear();
+				kwds.clear();
+				effects.clear();
+			}
+
+		private:
+			static Signature build(RE::MagicItem* spel)
+			{
+				Signature ans{ spel->formID };
+				ans.kwds.resize(kwds.size());
+				ans.effects.resize(effects.size());
+
+				for (auto eff : spel->effects) {
+					auto mgef = eff ? eff->baseEffect : nullptr;
+					if (!mgef)
+						continue;
+
+					if (auto bit = effects.find(mgef->formID))
+						ans.effects.set(*bit);
+
+					if (!kwds.empty()) {
+						for (uint32_t i = 0; i < mgef->numKeywords; i++) {
+							if (auto kwd = mgef->keywords[i]) {
+								if (auto bit = kwds.find(kwd->formID))
+									ans.kwds.set(*bit);
+							}
+						}
+					}
+				}
+				return ans;
+			}
+
+			static inline FormBits kwds;
+			static inline FormBits effects;
+
+			static inline std::mutex signatures_lock;
+			static inline std::unordered_map<RE::MagicItem*, Signature> signatures;
+		};
+
+		uint32_t add_effect_kwd(RE::FormID formid) { return Storage::add_effect_kwd(formid); }
+		uint32_t add_effect(RE::FormID formid) { return Storage::add_effect(formid); }
+		bool has_effect_kwd(RE::MagicItem* spel, uint32_t bit) { return Storage::has_effect_kwd(spel, bit); }
+		bool has_effect(RE::MagicItem* spel, uint32_t bit) { return Storage::has_effect(spel, bit); }
+	}
+
+	void install() { Keywords::EquipHandler::GetSingleton()->enable(); }
+
+	void clear()
+	{
+		Keywords::Storage::clear();
+		Spells::Storage::clear();
+	}
+
+	void reset() { Keywords::Storage::reset(); }
+}
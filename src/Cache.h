@@ -0,0 +1,49 @@
+#pragma once
+
+namespace Cache
+{
+	// Dynamic bitset over indices of forms, registered while reading json
+	class Bits
+	{
+		std::vector<uint64_t> words;
+
+	public:
+		void resize(uint32_t size) { words.assign((size + 63) / 64, 0); }
+		void set(uint32_t ind) { words[ind >> 6] |= 1ull << (ind & 63); }
+		bool test(uint32_t ind) const { return (ind >> 6) < words.size() && ((words[ind >> 6] >> (ind & 63)) & 1); }
+	};
+
+	// Keywords referenced by CasterHasKwd conditions
+	namespace Keywords
+	{
+		// Resolves keyword and returns its bit. Called while reading json
+		uint32_t add(RE::FormID formid);
+
+		// Whether actor, its base or any of its active effects has a keyword
+		bool caster_has(RE::Actor* caster, uint32_t bit);
+
+		// Actor's keywords may be changed, rebuild on next check
+		void invalidate(RE::TESObjectREFR* refr);
+	}
+
+	// Keywords and base effects of spells, referenced by EffectsHasKwd and EffectsIsFormID conditions
+	namespace Spells
+	{
+		// Called while reading json
+		uint32_t add_effect_kwd(RE::FormID formid);
+		uint32_t add_effect(RE::FormID formid);
+
+		// Whether any effect of the spell has a keyword
+		bool has_effect_kwd(RE::MagicItem* spel, uint32_t bit);
+		// Whether any effect of the spell is the effect
+		bool has_effect(RE::MagicItem* spel, uint32_t bit);
+	}
+
+	void install();
+
+	// Forget everything, registered forms are invalid now
+	void clear();
+
+	// Forget cached actors only (e.g. game is loaded)
+	void reset();
+}
@@ -4,16 +4,87 @@
 
 namespace Emitters
 {
+	// Speed by age of the projectile, as a part of its max speed. Baked into a table at load
 	struct SpeedData
 	{
 		enum class SpeedChangeTypes : uint32_t
 		{
 			Linear,
 			Quadratic,
-			Exponential
-		} type;
+			Exponential,
+			Custom
+		};
+
+		static constexpr uint32_t SAMPLES = 64;
+		static constexpr float MIN_SPEED = 1.0f / 70;  // start of Exponential, the lowest speed of any curve
 
 		float time;
+		std::array<float, SAMPLES + 1> table;  // at 0, 1/SAMPLES, ..., 1 of time
+
+		SpeedData() : time(0), table() {}
+		explicit SpeedData(const Json::Value& function) : time(JsonUtils::getFloat(function, "time"))
+		{
+			auto type = JsonUtils::read_enum<SpeedChangeTypes>(function, "speedType");
+
+			std::vector<std::pair<float, float>> points;  // for Custom
+			if (type == SpeedChangeTypes::Custom) {
+				const auto& json_points = function["points"];
+				for (int i = 0; i < static_cast<int>(json_points.size()); i++) {
+					points.emplace_back(json_points[i][0].asFloat(), json_points[i][1].asFloat());
+				}
+				std::sort(points.begin(), points.end());
+			}
+
+			for (uint32_t i = 0; i <= SAMPLES; i++) {
+				float x = static_cast<float>(i) / SAMPLES;
+				float y = 1.0f;
+				switch (type) {
+				case SpeedChangeTypes::Linear:
+					y = x;
+					break;
+				case SpeedChangeTypes::Quadratic:
+					y = x * x;
+					break;
+				case SpeedChangeTypes::Exponential:
+					y = std::pow(MIN_SPEED, 1.0f - x);
+					break;
+				case SpeedChangeTypes::Custom:
+					y = interpolate(points, x);
+					break;
+				}
+				table[i] = std::clamp(y, MIN_SPEED, 1.0f);
+			}
+		}
+
+		// Part of max speed at the given age
+		float get(float age) const
+		{
+			if (time <= 0 || age >= time)
+				return table[SAMPLES];
+
+			float pos = std::max(age, 0.0f) / time * SAMPLES;
+			auto i = std::min(static_cast<uint32_t>(pos), SAMPLES - 1);
+			return std::lerp(table[i], table[i + 1], pos - i);
+		}
+
+	private:
+		// Piecewise linear through the points, constant out of them
+		static float interpolate(const std::vector<std::pair<float, float>>& points, float x)
+		{
+			if (points.empty())
+				return 1.0f;
+
+			auto next = std::lower_bound(points.begin(), points.end(), std::make_pair(x, std::numeric_limits<float>::lowest()));
+			if (next == points.begin())
+				return next->second;
+			if (next == points.end())
+				return points.back().second;
+
+			auto prev = std::prev(next);
+			if (next->first <= prev->first)
+				return next->second;
+			return std::lerp(prev->second, next->second, (x - prev->first) / (next->first - prev->first));
+		}
 	};
 
 	struct FunctionData
@@ -31,8 +102,7 @@ namespace Emitters
 			Type type = JsonUtils::read_enum<Type>(function, "type");
 			switch (type) {
 			case Type::AccelerateToMaxSpeed:
-				data = SpeedData{ JsonUtils::read_enum<SpeedData::SpeedChangeTypes>(function, "speedType"),
-					JsonUtils::getFloat(function, "time") };
+				data = SpeedData(function);
 				break;
 			case Type::TriggerFunctions:
 				data = TriggerFunctions::Functions(filename, function["TriggerFunctions"]);
@@ -45,6 +115,16 @@ namespace Emitters
 		Type get_type() const { return static_cast<Type>(data.index()); }
 	};
 
+	// What to do with ticks missed during a long frame
+	enum class CatchUp : uint32_t
+	{
+		Skip,      // fire once, drop the missed ones
+		All,       // fire each of them, at most MAX_CATCH_UP
+		Aggregate  // fire once with all of them as a multiplier, they count for limited
+	};
+
+	constexpr uint32_t MAX_CATCH_UP = 16;
+
 	struct Data
 	{
 		std::vector<FunctionData> functions;
@@ -52,6 +132,7 @@ namespace Emitters
 		uint32_t limited: 1;
 		uint32_t count: 30;
 		uint32_t destroy_after: 1;
+		CatchUp catch_up;
 	};
 
 	struct Storage
@@ -83,6 +164,8 @@ namespace Emitters
 		static const auto& get_data(uint32_t ind) { return data_static[ind - 1]; }
 
 		static uint32_t get_key_ind(const std::string& filename, const std::string& key) { return keys.get(filename, key); }
+		static const std::string& get_key_name(uint32_t ind) { return keys.get_name(ind); }
+		static uint32_t find_key_ind(const std::string& name) { return keys.find(name); }
 
 	private:
 		static void read_json_entry(const std::string& filename, const std::string& key, const Json::Value& item)
@@ -94,7 +177,7 @@ namespace Emitters
 
 			data_static.emplace_back(std::vector<FunctionData>(), JsonUtils::getFloat(item, "interval"),
 				JsonUtils::mb_read_field<false>(item, "limited"), JsonUtils::mb_read_field<1u>(item, "count"),
-				JsonUtils::mb_read_field<false>(item, "destroyAfter"));
+				JsonUtils::mb_read_field<false>(item, "destroyAfter"), JsonUtils::mb_read_field<CatchUp::Skip>(item, "catchUp"));
 
 			auto& new_functions = data_static.back().functions;
 			for (size_t i = 0; i < functions.size(); i++) {
@@ -113,9 +196,163 @@ namespace Emitters
 		static inline std::vector<Data> data_static;
 	};
 
+	// Next ticks of emitters. Hierarchical timer wheel: level 0 slots are RESOLUTION long,
+	// a slot of each next level spans the whole previous level. Timers go down a level when their slot comes round,
+	// only the current slot of level 0 is looked at every tick.
+	class Timers
+	{
+		static constexpr double RESOLUTION = 1.0 / 60;
+		static constexpr uint32_t BITS = 6;
+		static constexpr uint64_t SLOTS = 1 << BITS;
+		static constexpr uint32_t LEVELS = 4;  // ~77 hours with 60 ticks per second, farther ones wait in overflow
+
+		struct Timer
+		{
+			RE::ProjectileHandle handle;
+			RE::FormID formID;
+			uint32_t id;
+			double due;  // seconds of clock
+		};
+
+		static inline std::mutex lock;
+		static inline std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS> wheel;
+		static inline std::vector<Timer> overflow;
+		static inline std::unordered_map<RE::FormID, uint32_t> active;  // id of the timer of a projectile
+		static inline uint32_t last_id = 0;
+		static inline uint64_t now = 0;  // last processed tick, tick i is at i * RESOLUTION seconds
+		static inline double clock = 0;  // seconds of game time since load
+
+		// first tick not earlier than time
+		static uint64_t get_tick(double time) { return static_cast<uint64_t>(std::ceil(time / RESOLUTION)); }
+
+		// earliest is now + 1 for new timers. Cascades run before the current slot of level 0 is collected,
+		// so timers due at now may still go there
+		static void insert(Timer&& timer, uint64_t earliest)
+		{
+			auto tick = std::max(get_tick(timer.due), earliest);
+			auto delta = tick - now;
+			for (uint32_t level = 0; level < LEVELS; level++) {
+				if (delta < (1ull << (BITS * (level + 1)))) {
+					wheel[level][(tick >> (BITS * level)) & (SLOTS - 1)].push_back(std::move(timer));
+					return;
+				}
+			}
+			overflow.push_back(std::move(timer));
+		}
+
+		static void cascade(std::vector<Timer>& slot)
+		{
+			auto timers = std::move(slot);
+			slot.clear();
+			for (auto& timer : timers) {
+				insert(std::move(timer), now);
+			}
+		}
+
+		// Move to the next tick, collect timers due at it
+		static void tick(std::vector<Timer>& ans)
+		{
+			now++;
+
+			if (now % (1ull << (BITS * LEVELS)) == 0)
+				cascade(overflow);
+
+			for (uint32_t level = LEVELS - 1; level > 0; level--) {
+				if (now % (1ull << (BITS * level)) == 0)
+					cascade(wheel[level][(now >> (BITS * level)) & (SLOTS - 1)]);
+			}
+
+			auto& slot = wheel[0][now & (SLOTS - 1)];
+			for (auto& timer : slot) {
+				if (auto found = active.find(timer.formID); found != active.end() && found->second == timer.id) {
+					active.erase(found);
+					ans.push_back(std::move(timer));
+				}
+			}
+			slot.clear();
+		}
+
+		static void schedule_impl(RE::Projectile* proj, double due)
+		{
+			auto id = ++last_id;
+			active[proj->formID] = id;
+			insert({ RE::ProjectileHandle(proj), proj->formID, id, due }, now + 1);
+		}
+
+	public:
+		// The emitter ticks after delay seconds from now
+		static void schedule(RE::Projectile* proj, float delay)
+		{
+			std::lock_guard guard(lock);
+			schedule_impl(proj, clock + delay);
+		}
+
+		// The emitter ticks at the given time of clock
+		static void schedule_at(RE::Projectile* proj, double due)
+		{
+			std::lock_guard guard(lock);
+			schedule_impl(proj, due);
+		}
+
+		// Its timer is dropped when it comes round
+		static void cancel(RE::Projectile* proj)
+		{
+			std::lock_guard guard(lock);
+			if (!active.empty())
+				active.erase(proj->formID);
+		}
+
+		static double get_clock()
+		{
+			std::lock_guard guard(lock);
+			return clock;
+		}
+
+		// Projectiles due during the last dtime seconds, with their due time
+		static std::vector<std::pair<RE::Projectile*, double>> advance(float dtime)
+		{
+			std::vector<Timer> due;
+			{
+				std::lock_guard guard(lock);
+
+				clock += dtime;
+				while ((now + 1) * RESOLUTION <= clock) {
+					tick(due);
+				}
+			}
+
+			std::vector<std::pair<RE::Projectile*, double>> ans;
+			for (const auto& timer : due) {
+				if (auto proj = timer.handle.get().get(); proj && proj->formID == timer.formID)
+					ans.emplace_back(proj, timer.due);
+			}
+			return ans;
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			for (auto& level : wheel) {
+				for (auto& slot : level) {
+					slot.clear();
+				}
+			}
+			overflow.clear();
+			active.clear();
+			now = 0;
+			clock = 0;
+		}
+	};
+
 	uint32_t get_key_ind(const std::string& filename, const std::string& key) { return Storage::get_key_ind(filename, key); }
+	const std::string& get_key_name(uint32_t ind) { return Storage::get_key_name(ind); }
+	uint32_t find_key_ind(const std::string& name) { return Storage::find_key_ind(name); }
 
-	void clear() { Storage::clear(); }
+	void clear()
+	{
+		Storage::clear();
+		Timers::clear();
+	}
 	void clear_keys() { Storage::clear_keys(); }
 
 	void init(const std::string& filename, const Json::Value& json_root)
@@ -135,7 +372,11 @@ namespace Emitters
 	void set_emitter_ind(RE::Projectile* proj, uint32_t ind) { ::set_emitter_ind(proj, ind); }
 	uint32_t get_emitter_ind(RE::Projectile* proj) { return ::get_emitter_ind(proj); }
 	bool is_emitter(RE::Projectile* proj) { return get_emitter_ind(proj) != 0; }
-	void disable_emitter(RE::Projectile* proj) { set_emitter_ind(proj, 0); }
+	void disable_emitter(RE::Projectile* proj)
+	{
+		set_emitter_ind(proj, 0);
+		Timers::cancel(proj);
+	}
 
 	void disable(RE::Projectile* proj)
 	{
@@ -154,60 +395,29 @@ namespace Emitters
 			if (data.limited) {
 				set_emitter_rest(proj, data.count);
 			}
+			Timers::schedule(proj, data.interval);
 		}
 	}
 
-	void onUpdate(RE::Projectile* proj, float dtime)
+	// Calls functions of the emitter for all of projs, function by function.
+	// ticks[i] is how many ticks the call stands for projs[i]
+	void onUpdate(const Data& data, const std::vector<RE::Projectile*>& projs, const std::vector<uint32_t>& ticks)
 	{
-		auto emitter_ind = get_emitter_ind(proj);
-
-		auto& data = Storage::get_data(emitter_ind);
-
-		if (proj->livingTime < data.interval)
-			return;
-
-		if (data.limited && get_emitter_rest(proj) == 0)
-			return;
-
-		proj->livingTime = 0.000001f;
-
 		for (const auto& function : data.functions) {
 			switch (function.get_type()) {
 			case FunctionData::Type::TriggerFunctions:
-				std::get<TriggerFunctions::Functions>(function.data).call(proj);
+				std::get<TriggerFunctions::Functions>(function.data).call_batch(projs, ticks);
 				break;
 			case FunctionData::Type::AccelerateToMaxSpeed:
 				{
-					// TODO: fix
-					// y = a*e^bx, a = M/X, b = ln X / N
-					//constexpr float X = 70.0f;
-					//constexpr float LN_X = 4.248495242049359f;  // ln 70
-					//float b = LN_X / function.args.time;
-					//float cur_speed = proj->linearVelocity.Length();
-					//float add_to_speed = exp(b * dtime);
-					//float new_speed = cur_speed * add_to_speed;
-					//proj->linearVelocity *= (new_speed / cur_speed);
-
-					float max_speed = FenixUtils::Projectile__GetSpeed(proj);
-					float cur_speed = proj->linearVelocity.Length();
-					if (cur_speed < max_speed) {
-						auto& function_speed = std::get<SpeedData>(function.data);
-						float TOTAL_TIME = function_speed.time;
-						float dspeed = 0;
-						switch (function_speed.type) {
-						case SpeedData::SpeedChangeTypes::Linear:
-							dspeed = max_speed / TOTAL_TIME * dtime;
-							break;
-						case SpeedData::SpeedChangeTypes::Quadratic:
-							dspeed = 2 * std::sqrt(cur_speed * max_speed) * TOTAL_TIME * dtime;
-							break;
-						case SpeedData::SpeedChangeTypes::Exponential:
-							dspeed = cur_speed * std::log(max_speed) / TOTAL_TIME * dtime;
-							break;
+					auto& speed_data = std::get<SpeedData>(function.data);
+					for (auto proj : projs) {
+						float max_speed = FenixUtils::Projectile__GetSpeed(proj);
+						float cur_speed = proj->linearVelocity.Length();
+						if (cur_speed > 0 && cur_speed < max_speed) {
+							float new_speed = max_speed * speed_data.get(proj->livingTime);
+							proj->linearVelocity *= (new_speed / cur_speed);
 						}
-
-						float new_speed = cur_speed + dspeed;
-						proj->linearVelocity *= (new_speed / cur_speed);
 					}
 				}
 				break;
@@ -217,18 +427,97 @@ namespace Emitters
 		}
 
 		if (data.limited) {
-			auto rest = get_emitter_rest(proj);
-			set_emitter_rest(proj, rest - 1);
-			if (rest == 1) {
-				if (data.destroy_after) {
-					proj->Kill();
-				} else {
-					disable_emitter(proj);
+			for (size_t i = 0; i < projs.size(); i++) {
+				auto proj = projs[i];
+				auto rest = get_emitter_rest(proj);
+				set_emitter_rest(proj, rest - std::min(rest, ticks[i]));
+				if (rest <= ticks[i]) {
+					if (data.destroy_after) {
+						proj->Kill();
+					} else {
+						disable_emitter(proj);
+					}
 				}
 			}
 		}
 	}
 
+	// Due projectiles of one emitter. All ticks missed since due are handled at once, next one is at the same pace
+	void fire(uint32_t ind, const std::vector<std::pair<RE::Projectile*, double>>& due, double clock)
+	{
+		auto& data = Storage::get_data(ind);
+
+		std::vector<uint32_t> missed;  // ticks due by now, for each one
+		missed.reserve(due.size());
+		for (const auto& [proj, time] : due) {
+			uint32_t ticks = 1;
+			if (data.interval > 0)
+				ticks += static_cast<uint32_t>(std::min((clock - time) / data.interval, static_cast<double>(UINT32_MAX - 1)));
+			missed.push_back(ticks);
+		}
+
+		// All fires in rounds, the first round is the only one for the others
+		uint32_t rounds = 1;
+		if (data.catch_up == CatchUp::All)
+			rounds = std::min(*std::max_element(missed.begin(), missed.end()), MAX_CATCH_UP);
+
+		std::vector<RE::Projectile*> projs;
+		std::vector<uint32_t> ticks;
+		for (uint32_t round = 0; round < rounds; round++) {
+			projs.clear();
+			ticks.clear();
+			for (size_t i = 0; i < due.size(); i++) {
+				auto proj = due[i].first;
+				if (get_emitter_ind(proj) != ind || (data.limited && get_emitter_rest(proj) == 0))
+					continue;
+				if (data.catch_up == CatchUp::All && missed[i] <= round)
+					continue;
+
+				projs.push_back(proj);
+				ticks.push_back(data.catch_up == CatchUp::Aggregate ? missed[i] : 1);
+			}
+			if (projs.empty())
+				break;
+
+			onUpdate(data, projs, ticks);
+		}
+
+		// functions may have disabled the emitter or applied another one, that one is already scheduled
+		for (size_t i = 0; i < due.size(); i++) {
+			auto [proj, time] = due[i];
+			if (get_emitter_ind(proj) == ind)
+				Timers::schedule_at(proj, time + static_cast<double>(data.interval) * missed[i]);
+		}
+	}
+
+	// Due emitters are grouped by emitter, each group is dispatched at once
+	void update(float dtime)
+	{
+		auto due = Timers::advance(dtime);
+		if (due.empty())
+			return;
+
+		std::map<uint32_t, std::vector<std::pair<RE::Projectile*, double>>> groups;
+		for (const auto& item : due) {
+			if (auto ind = get_emitter_ind(item.first))
+				groups[ind].push_back(item);
+		}
+
+		auto clock = Timers::get_clock();
+		for (const auto& [ind, group] : groups) {
+			fire(ind, group, clock);
+		}
+	}
+
+	void reset() { Timers::clear(); }
+
+	void on_destroyed(RE::Projectile* proj)
+	{
+		if (is_emitter(proj)) {
+			disable_emitter(proj);
+		}
+	}
+
 	namespace Hooks
 	{
 		class EmitterHook
@@ -236,24 +525,11 @@ namespace Emitters
 		public:
 			static void Hook()
 			{
-				_CheckExplosion = SKSE::GetTrampoline().write_call<5>(REL::ID(42852).address() + 0x680,
-					CheckExplosion);  // SkyrimSE.exe+745450
 				_AddImpact = SKSE::GetTrampoline().write_call<5>(REL::ID(42547).address() + 0x56,
 					AddImpact);  // SkyrimSE.exe+732456 -- disable on hit
-				_BSSoundHandle__ClearFollowedObject = SKSE::GetTrampoline().write_call<5>(REL::ID(42930).address() + 0x21,
-					BSSoundHandle__ClearFollowedObject);  // SkyrimSE.exe+74BC21 -- disable on kill
 			}
 
 		private:
-			static RE::Explosion* CheckExplosion(RE::MissileProjectile* proj, float dtime)
-			{
-				if (is_emitter(proj)) {
-					onUpdate(proj, dtime);
-				}
-
-				return _CheckExplosion(proj, dtime);
-			}
-
 			static void* AddImpact(RE::Projectile* proj, RE::TESObjectREFR* a2, RE::NiPoint3* a3, RE::NiPoint3* a_velocity,
 				RE::hkpCollidable* a_collidable, uint32_t a6, char a7)
 			{
@@ -263,18 +539,8 @@ namespace Emitters
 				}
 				return ans;
 			}
-			static void BSSoundHandle__ClearFollowedObject(char* sound)
-			{
-				_BSSoundHandle__ClearFollowedObject(sound);
-				auto proj = reinterpret_cast<RE::Projectile*>(sound - 0x128);
-				if (is_emitter(proj)) {
-					disable_emitter(proj);
-				}
-			}
 
-			static inline REL::Relocation<decltype(CheckExplosion)> _CheckExplosion;
 			static inline REL::Relocation<decltype(AddImpact)> _AddImpact;
-			static inline REL::Relocation<decltype(BSSoundHandle__ClearFollowedObject)> _BSSoundHandle__ClearFollowedObject;
 		};
 	}
 
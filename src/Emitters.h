@@ -5,6 +5,10 @@
 namespace Emitters
 {
 	uint32_t get_key_ind(const std::string& filename, const std::string& key);
+	// Name of the index that stays the same between sessions, ind is a valid index
+	const std::string& get_key_name(uint32_t ind);
+	// Index of a name from get_key_name, 0 if there is no such name
+	uint32_t find_key_ind(const std::string& name);
 	void install();
 	void init(const std::string& filename, const Json::Value& json_root);
 	void init_keys(const std::string& filename, const Json::Value& json_root);
@@ -12,4 +16,11 @@ namespace Emitters
 	void clear_keys();
 	void apply(RE::Projectile* proj, uint32_t ind);
 	void disable(RE::Projectile* proj);
+
+	// Fires emitters due in the last dtime seconds of game time. Called once per frame
+	void update(float dtime);
+	void reset();  // game is loaded
+
+	// From shared hooks, for emitters
+	void on_destroyed(RE::Projectile* proj);
 }
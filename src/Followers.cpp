@@ -2,7 +2,10 @@
 #include "JsonUtils.h"
 #include "RuntimeData.h"
 #include <algorithm>
+#include <bit>
+#include <unordered_set>
 #include "Positioning.h"
+#include "RoundingBatch.h"
 
 namespace Followers
 {
@@ -20,14 +23,17 @@ namespace Followers
 
 		Rounding rounding: 2;
 		Collision collision: 2;
+		uint32_t compact: 1;    // spread followers evenly over a layout of their count
 		float rounding_radius;  // if rounding
 		float speed_mult;       // 0 for instant, default: 1
+		float separation;       // followers closer than that push each other apart, 0 for none
 
 		explicit Data(const Json::Value& item) :
 			pattern(item["Pattern"]), rounding(JsonUtils::mb_read_field<Rounding::None>(item, "rounding")),
 			rounding_radius(rounding != Rounding::None ? JsonUtils::getFloat(item, "roundingR") : 0),
 			collision(JsonUtils::mb_read_field<Collision::Actor>(item, "collision")),
-			speed_mult(JsonUtils::mb_getFloat<1.0f>(item, "speed"))
+			compact(JsonUtils::mb_read_field<false>(item, "compact")), speed_mult(JsonUtils::mb_getFloat<1.0f>(item, "speed")),
+			separation(JsonUtils::mb_getFloat<0.0f>(item, "separation"))
 		{}
 	};
 	static_assert(sizeof(Data) == 0x40);
@@ -42,6 +48,7 @@ namespace Followers
 		{
 			clear_keys();
 			data_static.clear();
+			max_separation = 0;
 		}
 
 		static void init(const std::string& filename, const Json::Value& HomingData)
@@ -61,6 +68,10 @@ namespace Followers
 		static const auto& get_data(uint32_t ind) { return data_static[ind - 1]; }
 
 		static uint32_t get_key_ind(const std::string& filename, const std::string& key) { return keys.get(filename, key); }
+		static const std::string& get_key_name(uint32_t ind) { return keys.get_name(ind); }
+		static uint32_t find_key_ind(const std::string& name) { return keys.find(name); }
+
+		static float get_max_separation() { return max_separation; }
 
 	private:
 		static void read_json_entry(const std::string& filename, const std::string& key, const Json::Value& item)
@@ -68,7 +79,8 @@ namespace Followers
 			[[maybe_unused]] uint32_t ind = keys.get(filename, key);
 			assert(ind == data_static.size() + 1);
 
-			data_static.emplace_back(item);
+			const auto& data = data_static.emplace_back(item);
+			max_separation = std::max(max_separation, data.separation);
 		}
 
 		static void read_json_entry_keys(const std::string& filename, const std::string& key, const Json::Value&)
@@ -78,9 +90,12 @@ namespace Followers
 
 		static inline JsonUtils::KeysMap keys;
 		static inline std::vector<Data> data_static;
+		static inline float max_separation = 0;
 	};
 
 	uint32_t get_key_ind(const std::string& filename, const std::string& key) { return Storage::get_key_ind(filename, key); }
+	const std::string& get_key_name(uint32_t ind) { return Storage::get_key_name(ind); }
+	uint32_t find_key_ind(const std::string& name) { return Storage::find_key_ind(name); }
 
 	void set_follower_ind(RE::Projectile* proj, uint32_t ind) { ::set_follower_ind(proj, ind); }
 	uint32_t get_follower_ind(RE::Projectile* proj) { return ::get_follower_ind(proj); }
@@ -89,6 +104,349 @@ namespace Followers
 	bool is_follower(RE::Projectile* proj) { return get_follower_ind(proj) != 0; }
 	void disable_follower(RE::Projectile* proj) { set_follower_ind(proj, 0); }
 
+	// Occupied shape indexes of followers, per caster and follower type
+	class Slots
+	{
+		static inline std::mutex lock;
+		static inline std::unordered_map<uint64_t, std::vector<uint64_t>> slots;
+
+		static uint64_t get_key(RE::Projectile* proj, uint32_t ind)
+		{
+			// handle stays the same even if caster is unloaded
+			return (static_cast<uint64_t>(proj->shooter.native_handle()) << 32) | ind;
+		}
+
+	public:
+		static constexpr uint32_t MAX_SLOTS = 4096;  // bounds bitmaps of huge figures
+
+		// Marks the first free slot as occupied. -1 if all of them are occupied
+		static uint32_t acquire(RE::Projectile* proj, uint32_t ind, uint32_t size)
+		{
+			size = std::min(size, MAX_SLOTS);
+
+			std::lock_guard guard(lock);
+
+			auto& bits = slots[get_key(proj, ind)];
+			bits.resize((size + 63) / 64);
+			for (uint32_t i = 0; i < bits.size(); i++) {
+				if (auto free = ~bits[i]) {
+					uint32_t slot = i * 64 + std::countr_zero(free);
+					if (slot >= size)
+						break;
+
+					bits[i] |= 1ull << (slot & 63);
+					return slot;
+				}
+			}
+			return static_cast<uint32_t>(-1);
+		}
+
+		static void release(RE::Projectile* proj, uint32_t ind, uint32_t slot)
+		{
+			std::lock_guard guard(lock);
+
+			auto found = slots.find(get_key(proj, ind));
+			if (found == slots.end() || (slot >> 6) >= found->second.size())
+				return;
+
+			auto& bits = found->second;
+			bits[slot >> 6] &= ~(1ull << (slot & 63));
+			if (std::all_of(bits.begin(), bits.end(), [](uint64_t word) { return word == 0; }))
+				slots.erase(found);
+		}
+
+		// Compact mode: first `size` slots are occupied, positions are taken from a layout of that size
+		static void assign(RE::Projectile* proj, uint32_t ind, uint32_t size)
+		{
+			std::lock_guard guard(lock);
+
+			auto key = get_key(proj, ind);
+			if (size == 0) {
+				slots.erase(key);
+				layouts.erase(key);
+				return;
+			}
+
+			auto& bits = slots[key];
+			bits.assign((size + 63) / 64, ~0ull);
+			if (size & 63)
+				bits.back() = (1ull << (size & 63)) - 1;
+			layouts[key] = size;
+		}
+
+		// 0 if the figure is used as is
+		static uint32_t get_layout(RE::Projectile* proj, uint32_t ind)
+		{
+			std::lock_guard guard(lock);
+
+			auto found = layouts.find(get_key(proj, ind));
+			return found == layouts.end() ? 0 : found->second;
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			slots.clear();
+			layouts.clear();
+		}
+
+	private:
+		static inline std::unordered_map<uint64_t, uint32_t> layouts;
+	};
+
+	void release_slot(RE::Projectile* proj)
+	{
+		if (is_follower(proj) && get_follower_owns_slot(proj)) {
+			Slots::release(proj, get_follower_ind(proj), get_follower_shape_ind(proj));
+			set_follower_owns_slot(proj, false);
+		}
+	}
+
+	class LOD
+	{
+	public:
+		enum class Tier : uint32_t
+		{
+			Near,
+			Mid,
+			Far
+		};
+
+		static void set(const LODSettings& new_settings) { settings = new_settings; }
+
+		static void update()
+		{
+			frame++;
+
+			if (auto camera = RE::PlayerCamera::GetSingleton(); camera && camera->cameraRoot) {
+				const auto& world = camera->cameraRoot->world;
+				camera_pos = world.translate;
+				camera_dir = world.rotate * RE::NiPoint3(0, 1, 0);
+			}
+		}
+
+		static Tier get_tier(RE::Projectile* proj)
+		{
+			auto caster = proj->shooter.get().get();
+			if (!settings.enabled || !caster || caster->IsPlayerRef())
+				return Tier::Near;
+
+			auto dir = caster->GetPosition() - camera_pos;
+			float dist2 = dir.SqrLength();
+			bool visible = caster->Is3DLoaded() && dir.Dot(camera_dir) > 0;
+
+			if (!visible || dist2 > settings.far_dist * settings.far_dist)
+				return Tier::Far;
+			if (dist2 > settings.near_dist * settings.near_dist)
+				return Tier::Mid;
+			return Tier::Near;
+		}
+
+		// Followers of a tier are spread over frames by formID
+		static bool is_update_frame(RE::Projectile* proj, Tier tier)
+		{
+			uint32_t interval = tier == Tier::Far ? settings.far_interval : tier == Tier::Mid ? settings.mid_interval : 1;
+			return interval <= 1 || (frame + proj->formID) % interval == 0;
+		}
+
+		static bool snap(Tier tier) { return tier == Tier::Far && settings.snap_far; }
+
+		static uint32_t get_frame() { return frame; }
+
+	private:
+		static inline LODSettings settings{ true, 2048.0f, 6144.0f, 2, 4, true };
+		static inline uint32_t frame = 0;
+		static inline RE::NiPoint3 camera_pos;
+		static inline RE::NiPoint3 camera_dir;
+	};
+
+	// Followers of a still caster that reached their slots stop moving until the caster moves
+	class Sleep
+	{
+		struct Caster
+		{
+			RE::NiPoint3 pos;
+			RE::NiPoint3 angle;
+			uint32_t frame;
+			bool still;
+		};
+
+		static constexpr float POS_EPS = 0.5f;
+		static constexpr float ANGLE_EPS = 0.001f;
+		static constexpr float SLOT_EPS = 2.0f;
+		static constexpr uint32_t PRUNE_FRAMES = 600;
+
+		static inline std::mutex lock;
+		static inline std::unordered_map<uint32_t, Caster> casters;  // by handle
+		static inline std::unordered_set<RE::FormID> sleeping;
+
+		static bool is_close(const RE::NiPoint3& a, const RE::NiPoint3& b, float eps)
+		{
+			return std::abs(a.x - b.x) < eps && std::abs(a.y - b.y) < eps && std::abs(a.z - b.z) < eps;
+		}
+
+	public:
+		// Caster has not moved nor turned since the last frame. Checked once per frame
+		static bool is_caster_still(RE::Projectile* proj)
+		{
+			auto caster = proj->shooter.get().get();
+			if (!caster)
+				return false;
+
+			std::lock_guard guard(lock);
+
+			auto frame = LOD::get_frame();
+			auto [found, inserted] = casters.try_emplace(proj->shooter.native_handle(),
+				Caster{ caster->GetPosition(), caster->data.angle, frame, false });
+			auto& state = found->second;
+			if (!inserted && state.frame != frame) {
+				auto pos = caster->GetPosition();
+				state.still = is_close(pos, state.pos, POS_EPS) && is_close(caster->data.angle, state.angle, ANGLE_EPS);
+				state.pos = pos;
+				state.angle = caster->data.angle;
+				state.frame = frame;
+			}
+			return state.still;
+		}
+
+		// Follower is at its slot and looks where the caster does
+		static bool is_settled(RE::Projectile* proj, const RE::NiPoint3& target_pos)
+		{
+			return proj->GetPosition().GetSquaredDistance(target_pos) < SLOT_EPS * SLOT_EPS &&
+			       is_close(proj->data.angle, proj->shooter.get().get()->data.angle, ANGLE_EPS * 10);
+		}
+
+		static bool is_sleeping(RE::Projectile* proj)
+		{
+			std::lock_guard guard(lock);
+			return !sleeping.empty() && sleeping.contains(proj->formID);
+		}
+
+		static void sleep(RE::Projectile* proj)
+		{
+			std::lock_guard guard(lock);
+			sleeping.insert(proj->formID);
+		}
+
+		static void wake(RE::Projectile* proj)
+		{
+			std::lock_guard guard(lock);
+			if (!sleeping.empty())
+				sleeping.erase(proj->formID);
+		}
+
+		// Forget casters that have no followers for a while
+		static void update()
+		{
+			auto frame = LOD::get_frame();
+			if (frame % PRUNE_FRAMES)
+				return;
+
+			std::lock_guard guard(lock);
+			std::erase_if(casters, [frame](const auto& item) { return frame - item.second.frame > PRUNE_FRAMES; });
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			casters.clear();
+			sleeping.clear();
+		}
+	};
+
+	// Followers with separation push each other apart, boids-like. Neighbours are found
+	// through a spatial hash of positions of the previous frame, cells are of the max separation.
+	class Separation
+	{
+		struct Entry
+		{
+			RE::FormID formID;
+			RE::NiPoint3 pos;
+		};
+
+		static inline std::mutex lock;
+		static inline std::unordered_map<uint64_t, std::vector<Entry>> cur;   // filled this frame
+		static inline std::unordered_map<uint64_t, std::vector<Entry>> prev;  // looked up this frame
+
+		static int32_t get_cell(float coord) { return static_cast<int32_t>(std::floor(coord / Storage::get_max_separation())); }
+
+		static uint64_t get_key(int32_t x, int32_t y, int32_t z)
+		{
+			constexpr uint64_t MASK = (1 << 21) - 1;
+			return ((x & MASK) << 42) | ((y & MASK) << 21) | (z & MASK);
+		}
+
+	public:
+		static constexpr float GAIN = 4.0f;  // push speed per unit of overlap, times speed_mult
+
+		static void add(RE::Projectile* proj)
+		{
+			auto pos = proj->GetPosition();
+			auto key = get_key(get_cell(pos.x), get_cell(pos.y), get_cell(pos.z));
+
+			std::lock_guard guard(lock);
+			cur[key].push_back({ proj->formID, pos });
+		}
+
+		// Sum of overlaps with the neighbours, directed away from them
+		static RE::NiPoint3 get_push(RE::Projectile* proj, float radius)
+		{
+			RE::NiPoint3 ans;
+
+			auto pos = proj->GetPosition();
+			int32_t x = get_cell(pos.x), y = get_cell(pos.y), z = get_cell(pos.z);
+
+			std::lock_guard guard(lock);
+			if (prev.empty())
+				return ans;
+
+			for (int32_t dx = -1; dx <= 1; dx++) {
+				for (int32_t dy = -1; dy <= 1; dy++) {
+					for (int32_t dz = -1; dz <= 1; dz++) {
+						auto found = prev.find(get_key(x + dx, y + dy, z + dz));
+						if (found == prev.end())
+							continue;
+
+						for (const auto& other : found->second) {
+							if (other.formID == proj->formID)
+								continue;
+
+							auto dir = pos - other.pos;
+							float dist = dir.Length();
+							if (dist >= radius)
+								continue;
+
+							if (dist < 0.01f) {
+								// same point, split them in opposite directions
+								float angle = static_cast<float>((proj->formID ^ other.formID) % 628) / 100.0f;
+								float sign = proj->formID < other.formID ? 1.0f : -1.0f;
+								dir = RE::NiPoint3(cosf(angle), sinf(angle), 0) * sign;
+							} else {
+								dir /= dist;
+							}
+							ans += dir * (radius - dist);
+						}
+					}
+				}
+			}
+			return ans;
+		}
+
+		static void update()
+		{
+			std::lock_guard guard(lock);
+			std::swap(cur, prev);
+			cur.clear();
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			cur.clear();
+			prev.clear();
+		}
+	};
+
 	namespace Moving
 	{
 		auto get_target_point(RE::Projectile* proj)
@@ -104,170 +462,119 @@ namespace Followers
 			RE::NiPoint3 cast_dir = data.pattern.getCastDir(dir);
 			cast_dir.Unitize();
 
-			return data.pattern.GetPosition(spawn_center, cast_dir, get_follower_shape_ind(proj));
+			uint32_t layout = data.compact ? Slots::get_layout(proj, get_follower_ind(proj)) : 0;
+			return data.pattern.GetPosition(spawn_center, cast_dir, get_follower_shape_ind(proj), layout);
 		}
 
-		RE::NiPoint2 rotate(RE::NiPoint2 P, float alpha)
+		RE::NiPoint3 get_cast_dir_rounding_plane(RE::Projectile* proj, const Data& data)
 		{
-			float _cos = cosf(alpha);
-			float _sin = sin(alpha);
-			return { P.x * _cos - P.y * _sin, P.y * _cos + P.x * _sin };
+			auto caster = proj->shooter.get().get()->As<RE::Actor>();
+			RE::NiPoint3 cast_dir = data.pattern.getCastDir({ caster->GetAngleX(), caster->GetAngleZ() });
+			cast_dir.Unitize();
+			return cast_dir;
 		}
 
-		const float CIRCLE_K = 0.01f;
-		const float CIRCLE_K_BIG = 1.0f + CIRCLE_K;
-		const float CIRCLE_K_SML = 1.0f - CIRCLE_K;
+		// Time of the frame from the move of MovePoint, 0 if the projectile stands
+		float get_dtime(RE::Projectile* proj, RE::NiPoint3* dV)
+		{
+			float speed2 = proj->linearVelocity.SqrLength();
+			return speed2 > 0 ? sqrtf(dV->SqrLength() / speed2) : 0.0f;
+		}
 
-		RE::NiPoint3 get_target_point_rounding_sphere(RE::Projectile* proj, RE::NiPoint3* dV)
+		// Rounding followers of all casters are gathered once per frame into contiguous arrays and integrated
+		// in one pass (see RoundingBatch), then each MovePoint call takes its result.
+		// Both run in the main thread, so the results are read without a lock.
+		class Batch
 		{
-			auto& data = Storage::get_data(get_follower_ind(proj));
+			static inline RoundingBatch::Arrays arrays;
+			static inline std::vector<RE::Projectile*> projs;  // of arrays, formIDs are reused
+			static inline std::unordered_map<RE::FormID, uint32_t> index;
+			static inline uint32_t frame = static_cast<uint32_t>(-1);
 
-			auto target_pos = get_target_point(proj);
-			float D2 = proj->GetPosition().GetSquaredDistance(target_pos);
-
-			float dtime = sqrtf(dV->SqrLength() / proj->linearVelocity.SqrLength());
-			float speed_origin = proj->linearVelocity.Length();
-			float R = data.rounding_radius;
-			float R2 = R * R;
-
-			auto cast_dir = proj->linearVelocity.UnitCross(target_pos - proj->GetPosition());
-			Positioning::Plane plane(target_pos, cast_dir);
-
-			//draw_circle0(target_pos, R, cast_dir);
-
-			if (D2 > R2 * CIRCLE_K_BIG * CIRCLE_K_BIG) {
-				// Out of circle
-				// Move to tangent
-				RE::NiPoint2 P = plane.project(proj->GetPosition() - target_pos);
-				RE::NiPoint2 vel = plane.project(proj->linearVelocity);
-
-				RE::NiPoint2 Q = { -P.y, P.x };
-				auto d2 = P.SqrLength();
-				float a = R2 / d2;
-				float b = R / d2 * sqrtf(d2 - R2);
-				if (P.Cross(vel) < 0)
-					b *= -1;
-				auto T3 = plane.unproject(P * a + Q * b);
-				auto V = T3 - proj->GetPosition();
-				float len = V.Unitize();
-				auto my_len = speed_origin * dtime;
-				float circle_len = my_len - len;
-				if (circle_len > 0) {
-					return FenixUtils::Geom::rotate(T3, circle_len / R, target_pos, cast_dir);
-				} else {
-					return V * my_len + proj->GetPosition();
-				}
-			} else if (D2 < R2 * CIRCLE_K_SML * CIRCLE_K_SML) {
-				// Inside of circle
-				// Slightly rotate velocity to tangent
-
-				RE::NiPoint3 proj_dir_final = (proj->GetPosition() - target_pos).UnitCross(cast_dir);
-				if (proj_dir_final.Dot(proj->linearVelocity) < 0) {
-					proj_dir_final *= -1;
-				} else {
-				}
+			static RoundingBatch::Vec to_vec(const RE::NiPoint3& P) { return { P.x, P.y, P.z }; }
 
-				proj->linearVelocity =
-					FenixUtils::Geom::rotateVel(proj->linearVelocity, dtime * speed_origin / R, proj_dir_final);
+			// Same conditions as in change_direction_instant
+			static bool is_rounding_now(RE::Projectile* proj)
+			{
+				if (!is_follower(proj))
+					return false;
 
-				return proj->GetPosition() + proj->linearVelocity * dtime;
-			} else {
-				// On circle
-				// Move around the circle
-
-				float phi = dtime * speed_origin / R;
-				RE::NiPoint3 proj_dir_final = (proj->GetPosition() - target_pos).UnitCross(cast_dir);
-				if (proj_dir_final.Dot(proj->linearVelocity) < 0) {
-					proj_dir_final *= -1;
-				} else {
-					phi *= -1;
-				}
+				auto caster = proj->shooter.get().get();
+				if (!caster || !caster->As<RE::Actor>())
+					return false;
 
-				proj->linearVelocity = proj_dir_final * speed_origin;
-				return FenixUtils::Geom::rotate(proj->GetPosition(), phi, target_pos, cast_dir);
-			}
-		}
+				auto& data = Storage::get_data(get_follower_ind(proj));
+				if (data.rounding == Rounding::None || data.speed_mult == 0)
+					return false;
 
-		RE::NiPoint3 get_target_point_rounding_plane(RE::Projectile* proj, RE::NiPoint3* dV)
-		{
-			auto& data = Storage::get_data(get_follower_ind(proj));
+				auto tier = LOD::get_tier(proj);
+				return LOD::is_update_frame(proj, tier) && !LOD::snap(tier);
+			}
 
-			auto target_pos = get_target_point(proj);
+			static void add(RoundingBatch::Arrays& dest, RE::Projectile* proj, float dtime)
+			{
+				auto& data = Storage::get_data(get_follower_ind(proj));
 
-			float dtime = sqrtf(dV->SqrLength() / proj->linearVelocity.SqrLength());
-			float speed_origin = proj->linearVelocity.Length();
-			float R = data.rounding_radius;
-			float R2 = R * R;
+				// cast dir is the axis of Plane, and of Sphere if velocity looks at the target
+				dest.add(to_vec(proj->GetPosition()), to_vec(proj->linearVelocity), to_vec(get_target_point(proj)),
+					to_vec(get_cast_dir_rounding_plane(proj, data)), data.rounding_radius, dtime,
+					data.rounding == Rounding::Sphere);
+			}
 
-			auto caster = proj->shooter.get().get()->As<RE::Actor>();
-			RE::NiPoint3 cast_dir = data.pattern.getCastDir({ caster->GetAngleX(), caster->GetAngleZ() });
-			cast_dir.Unitize();
-			Positioning::Plane plane(target_pos, cast_dir);
-
-			float dir_z = -cast_dir.Dot(proj->GetPosition() - target_pos);
-			RE::NiPoint2 P = plane.project(proj->GetPosition() - target_pos);
-			RE::NiPoint2 vel = plane.project(proj->linearVelocity);
-
-			float D2 = P.SqrLength();
-
-			if (D2 > R2 * CIRCLE_K_BIG * CIRCLE_K_BIG) {
-				// Out of cylinder
-				// Move to tangent
-				
-				RE::NiPoint2 Q = { -P.y, P.x };
-				float a = R2 / D2;
-				float b = R / D2 * sqrtf(D2 - R2);
-				if (P.Cross(vel) < 0)
-					b *= -1;
-				auto T3 = plane.unproject(P * a + Q * b);
-				auto V = T3 - proj->GetPosition();
-				float len = V.Unitize();
-				auto my_len = speed_origin * dtime;
-				float circle_len = my_len - len;
-				if (circle_len > 0) {
-					return FenixUtils::Geom::rotate(T3, circle_len / R, target_pos, cast_dir);
-				} else {
-					return V * my_len + proj->GetPosition();
+		public:
+			// Called once per frame, after LOD
+			static void update(float dtime)
+			{
+				arrays.clear();
+				projs.clear();
+				index.clear();
+				frame = LOD::get_frame();
+
+				for (const auto& handle : Registry::get_all(Registry::Role::Follower)) {
+					if (auto proj = handle.get().get(); proj && is_rounding_now(proj)) {
+						index.insert({ proj->formID, static_cast<uint32_t>(projs.size()) });
+						projs.push_back(proj);
+						add(arrays, proj, dtime);
+					}
 				}
-			} else if (D2 < R2 * CIRCLE_K_SML * CIRCLE_K_SML) {
-				// Inside of cylinder
-				// Slightly rotate velocity to tangent
 
-				RE::NiPoint3 proj_dir_final = (proj->GetPosition() - target_pos).UnitCross(cast_dir);
-				if (proj_dir_final.Dot(proj->linearVelocity) < 0) {
-					proj_dir_final *= -1;
-				}
+				RoundingBatch::integrate(arrays);
+			}
+
+			// Next position of the follower, false if it is not in the batch
+			static bool get_next_pos(RE::Projectile* proj, RE::NiPoint3& ans)
+			{
+				if (frame != LOD::get_frame())
+					return false;
 
-				proj->linearVelocity =
-					FenixUtils::Geom::rotateVel(proj->linearVelocity, dtime * speed_origin / R, proj_dir_final);
+				auto found = index.find(proj->formID);
+				if (found == index.end() || projs[found->second] != proj)
+					return false;
 
-				return proj->GetPosition() + proj->linearVelocity * dtime;
-			} else {
-				// On cylinder
-				// Move around the cylinder
+				auto P = arrays.get(found->second);
+				ans = { P.x, P.y, P.z };
+				return true;
+			}
 
-				float L = dtime * speed_origin;
-				float H = abs(dir_z);
-				float t;
+			// Follower that is not gathered, e.g. became a follower in this frame
+			static RE::NiPoint3 get_next_pos_single(RE::Projectile* proj, float dtime)
+			{
+				RoundingBatch::Arrays single;
+				add(single, proj, dtime);
+				RoundingBatch::integrate(single);
 
-				if (L > H + 0.0001f) {
-					t = std::min(1.0f, H / sqrtf(L * L - H * H));
-				} else {
-					t = 1;
-				}
+				auto P = single.get(0);
+				return { P.x, P.y, P.z };
+			}
 
-				float dl = L / sqrtf(1 + t * t);
-				float dh = dl * t;
-				float df = dl / R;
-				if (P.Cross(vel) >= 0)
-					df *= -1;
-				auto ans = FenixUtils::Geom::rotate(proj->GetPosition(), df, target_pos, cast_dir);
-				if (dir_z < 0)
-					dh *= -1;
-				ans += cast_dir * dh;
-				return ans;
+			static void clear()
+			{
+				arrays.clear();
+				projs.clear();
+				index.clear();
+				frame = static_cast<uint32_t>(-1);
 			}
-		}
+		};
 
 		void change_direction_linVel(RE::Projectile* proj, const RE::NiPoint3& target_pos, float speed_mult)
 		{
@@ -279,11 +586,43 @@ namespace Followers
 			proj->linearVelocity = dir * speed;
 		}
 		
+		// Add push to the velocity, not faster than the projectile
+		void apply_separation(RE::Projectile* proj, const RE::NiPoint3& push)
+		{
+			if (push.SqrLength() == 0)
+				return;
+
+			auto vel = proj->linearVelocity + push;
+			auto speed = FenixUtils::Projectile__GetSpeed(proj);
+			if (vel.SqrLength() > speed * speed) {
+				vel.Unitize();
+				vel *= speed;
+			}
+			proj->linearVelocity = vel;
+		}
+
 		void change_direction(RE::Projectile* proj, RE::NiPoint3*, float dtime)
 		{
-			auto target_pos = get_target_point(proj);
+			// keep moving with the same velocity
+			if (!LOD::is_update_frame(proj, LOD::get_tier(proj)))
+				return;
 
 			auto& data = Storage::get_data(get_follower_ind(proj));
+
+			RE::NiPoint3 push;
+			if (data.separation > 0)
+				push = Separation::get_push(proj, data.separation);
+
+			// rounding followers never stop, pushed ones wake up
+			bool still = data.rounding == Rounding::None && Sleep::is_caster_still(proj);
+			if (still && Sleep::is_sleeping(proj) && push.SqrLength() == 0) {
+				proj->linearVelocity = RE::NiPoint3();
+				return;
+			}
+			Sleep::wake(proj);
+
+			auto target_pos = get_target_point(proj);
+
 			switch (data.rounding) {
 			case Rounding::Sphere:
 				//change_direction_rounding_sphere(proj, target_pos, dtime);
@@ -294,6 +633,8 @@ namespace Followers
 			case Rounding::None:
 			default:
 				change_direction_linVel(proj, target_pos, data.speed_mult);
+				if (data.separation > 0)
+					apply_separation(proj, push * (Separation::GAIN * data.speed_mult));
 				break;
 			}
 
@@ -307,28 +648,49 @@ namespace Followers
 				proj_dir = FenixUtils::Geom::rotateVel(proj_dir_cur, data.speed_mult * dtime, proj_dir_final);
 			}
 			FenixUtils::Geom::Projectile::update_node_rotation(proj, proj_dir);
-			
+
+			if (still && push.SqrLength() == 0 && Sleep::is_settled(proj, target_pos)) {
+				proj->linearVelocity = RE::NiPoint3();
+				Sleep::sleep(proj);
+			}
 		}
 
 		void change_direction_instant(RE::Projectile* proj, RE::NiPoint3* dV)
 		{
 			auto& data = Storage::get_data(get_follower_ind(proj));
 
+			// seen by the others in the next frame, whether it moves this one or not
+			if (data.separation > 0)
+				Separation::add(proj);
+
+			auto tier = LOD::get_tier(proj);
+			if (!LOD::is_update_frame(proj, tier))
+				return;
+
+			if (Sleep::is_sleeping(proj)) {
+				*dV = RE::NiPoint3();
+				return;
+			}
+
 			RE::NiPoint3 P;
 			RE::NiPoint3 proj_dir;
-			if (data.speed_mult == 0) {
+			bool snap = LOD::snap(tier);
+			if (data.speed_mult == 0 || snap) {
 				P = get_target_point(proj);
 				proj_dir = FenixUtils::Geom::angles2dir(proj->shooter.get().get()->data.angle);
 				proj_dir.Unitize();
-			} else if (data.rounding == Rounding::Sphere) {
-				P = get_target_point_rounding_sphere(proj, dV);
-			} else if (data.rounding == Rounding::Plane) {
-				P = get_target_point_rounding_plane(proj, dV);
-			} else {
+			} else if (data.rounding == Rounding::None) {
 				return;
+			} else if (!Batch::get_next_pos(proj, P)) {
+				P = Batch::get_next_pos_single(proj, get_dtime(proj, dV));
+			}
+
+			// instant followers stay at their slots
+			if (!snap && data.speed_mult > 0 && data.separation > 0) {
+				P += Separation::get_push(proj, data.separation) * (Separation::GAIN * data.speed_mult * get_dtime(proj, dV));
 			}
 
-			if (data.rounding == Rounding::Sphere || data.rounding == Rounding::Plane) {
+			if (!snap && (data.rounding == Rounding::Sphere || data.rounding == Rounding::Plane)) {
 				proj_dir = P - proj->GetPosition();
 				proj_dir.Unitize();
 				proj->linearVelocity = proj_dir * proj->linearVelocity.Length();
@@ -339,6 +701,123 @@ namespace Followers
 		}
 	}
 
+	// Compact mode: followers of the caster own slots [0, size) of an evenly spaced layout of that size.
+	// A join takes the next slot. A leave gives the freed slot to the nearest spare follower, without one the followers
+	// above it shift down by one, so their order along the figure is kept and each moves to a neighbouring place.
+
+	// Other followers of the same caster and type
+	std::vector<RE::Projectile*> get_group(RE::Projectile* proj, uint32_t ind)
+	{
+		std::vector<RE::Projectile*> ans;
+		auto caster = proj->shooter.get().get();
+		if (!caster)
+			return ans;
+
+		for (const auto& handle : Registry::get(caster, Registry::Role::Follower)) {
+			if (auto _proj = handle.get().get(); _proj && _proj != proj && get_follower_ind(_proj) == ind &&
+												 _proj->shooter.native_handle() == proj->shooter.native_handle()) {
+				ans.push_back(_proj);
+			}
+		}
+		return ans;
+	}
+
+	// Layout is resized, so targets of all followers are moved
+	void wake_all(const std::vector<RE::Projectile*>& group)
+	{
+		for (auto _proj : group) {
+			Sleep::wake(_proj);
+		}
+	}
+
+	// Takes the slot next to the last one
+	void join_compact(RE::Projectile* proj, uint32_t ind)
+	{
+		auto& data = Storage::get_data(ind);
+		auto size = Slots::get_layout(proj, ind);
+		if (size >= std::min(data.pattern.getSize(), Slots::MAX_SLOTS)) {
+			// all are occupied, share the first one
+			set_follower_shape_ind(proj, 0);
+			set_follower_owns_slot(proj, false);
+			return;
+		}
+
+		Slots::assign(proj, ind, size + 1);
+		set_follower_shape_ind(proj, size);
+		set_follower_owns_slot(proj, true);
+		wake_all(get_group(proj, ind));
+	}
+
+	// The freed slot is taken by the nearest follower without a slot, if there is none, the layout shrinks
+	void leave_compact(RE::Projectile* proj, uint32_t ind)
+	{
+		if (!get_follower_owns_slot(proj))
+			return;
+
+		set_follower_owns_slot(proj, false);
+
+		auto size = Slots::get_layout(proj, ind);
+		auto slot = get_follower_shape_ind(proj);
+		if (size == 0 || slot >= size)
+			return;
+
+		std::optional<RE::NiPoint3> slot_pos;
+		if (auto caster = proj->shooter.get().get(); caster && caster->As<RE::Actor>()) {
+			auto& data = Storage::get_data(ind);
+			RE::Projectile::ProjectileRot dir{ caster->GetAngleX(), caster->GetAngleZ() };
+			RE::NiPoint3 spawn_center = caster->GetPosition();
+			data.pattern.initCenter(spawn_center, dir, caster);
+			RE::NiPoint3 cast_dir = data.pattern.getCastDir(dir);
+			cast_dir.Unitize();
+			slot_pos = data.pattern.GetPosition(spawn_center, cast_dir, slot, size);
+		}
+
+		auto group = get_group(proj, ind);
+
+		RE::Projectile* spare = nullptr;
+		float spare_dist2 = std::numeric_limits<float>::max();
+		for (auto _proj : group) {
+			if (!get_follower_owns_slot(_proj)) {
+				float dist2 = slot_pos ? _proj->GetPosition().GetSquaredDistance(*slot_pos) : 0.0f;
+				if (!spare || dist2 < spare_dist2) {
+					spare = _proj;
+					spare_dist2 = dist2;
+				}
+			}
+		}
+
+		if (spare) {
+			set_follower_shape_ind(spare, slot);
+			set_follower_owns_slot(spare, true);
+			Sleep::wake(spare);
+			return;
+		}
+
+		for (auto _proj : group) {
+			if (get_follower_owns_slot(_proj)) {
+				if (auto cur = get_follower_shape_ind(_proj); cur > slot)
+					set_follower_shape_ind(_proj, cur - 1);
+			}
+		}
+		Slots::assign(proj, ind, size - 1);
+		wake_all(group);
+	}
+
+	// Follower is disabled or killed
+	void leave(RE::Projectile* proj)
+	{
+		if (!is_follower(proj))
+			return;
+
+		Sleep::wake(proj);
+
+		auto ind = get_follower_ind(proj);
+		if (Storage::get_data(ind).compact)
+			leave_compact(proj, ind);
+		else
+			release_slot(proj);
+	}
+
 	namespace Hooks
 	{
 		// Make projectile follow the caster
@@ -347,22 +826,11 @@ namespace Followers
 		public:
 			static void Hook()
 			{
-				_Projectile__apply_gravity = SKSE::GetTrampoline().write_call<5>(REL::ID(43006).address() + 0x69,
-					change_direction);  // SkyrimSE.exe+751309
 				_Projectile__MovePoint = SKSE::GetTrampoline().write_call<5>(REL::ID(43006).address() + 0x85,
 					change_direction_instant);  // 140751325
 			}
 
 		private:
-			static bool change_direction(RE::Projectile* proj, RE::NiPoint3* dV, float dtime)
-			{
-				bool ans = _Projectile__apply_gravity(proj, dV, dtime);
-				if (is_follower(proj)) {
-					Moving::change_direction(proj, dV, dtime);
-				}
-				return ans;
-			}
-
 			static void change_direction_instant(RE::Projectile* proj, RE::NiPoint3* dV)
 			{
 				if (is_follower(proj)) {
@@ -372,7 +840,6 @@ namespace Followers
 				_Projectile__MovePoint(proj, dV);
 			}
 
-			static inline REL::Relocation<decltype(change_direction)> _Projectile__apply_gravity;
 			static inline REL::Relocation<decltype(change_direction_instant)> _Projectile__MovePoint;
 		};
 
@@ -418,56 +885,16 @@ namespace Followers
 		};
 	}
 
-	void get_unused_shape_ind(RE::Projectile* proj, std::set<uint32_t>& ans, const RE::BSTArray<RE::ProjectileHandle>& a)
-	{
-		auto baseType = get_follower_ind(proj);
-		for (auto& i : a) {
-			if (auto _proj = i.get().get(); _proj && get_follower_ind(_proj) == baseType && _proj->formID != proj->formID) {
-				uint32_t ind = get_follower_shape_ind(_proj);
-				ans.erase(ind);
-			}
-		}
-	}
-
-	uint32_t get_unused_shape_ind(RE::Projectile* proj)
-	{
-		std::set<uint32_t> ans;
-		{
-			auto& data = Storage::get_data(get_follower_ind(proj));
-			int tmp = 0;
-			std::generate_n(std::inserter(ans, ans.begin()), data.pattern.getSize(), [&tmp]() { return tmp++; });
-		}
-
-		auto manager = RE::Projectile::Manager::GetSingleton();
-		get_unused_shape_ind(proj, ans, manager->limited);
-		get_unused_shape_ind(proj, ans, manager->pending);
-		get_unused_shape_ind(proj, ans, manager->unlimited);
-		return ans.begin() == ans.end() ? -1 : *ans.begin();
-	}
-
-	forEachRes forEachFollower(RE::TESObjectREFR* a, const RE::BSTArray<RE::ProjectileHandle>& arr,
-		const forEachF& func)
+	void forEachFollower(RE::TESObjectREFR* a, const forEachF& func)
 	{
-		for (auto& i : arr) {
-			if (auto proj = i.get().get(); proj && proj->shooter.get().get()) {
+		for (const auto& handle : Registry::get(a, Registry::Role::Follower)) {
+			if (auto proj = handle.get().get(); proj && proj->shooter.get().get()) {
 				if (proj->shooter.get().get()->formID == a->formID && is_follower(proj)) {
 					if (func(proj) == forEachRes::kStop)
-						return forEachRes::kStop;
+						return;
 				}
 			}
 		}
-		return forEachRes::kContinue;
-	}
-
-	void forEachFollower(RE::TESObjectREFR* a, const forEachF& func)
-	{
-		auto manager = RE::Projectile::Manager::GetSingleton();
-		if (forEachFollower(a, manager->limited, func) == forEachRes::kStop)
-			return;
-		if (forEachFollower(a, manager->pending, func) == forEachRes::kStop)
-			return;
-		if (forEachFollower(a, manager->unlimited, func) == forEachRes::kStop)
-			return;
 	}
 
 	void disable(RE::Projectile* proj, bool restore_speed)
@@ -481,6 +908,7 @@ namespace Followers
 				}
 			}
 			FenixUtils::Projectile__set_collision_layer(proj, RE::COL_LAYER::kSpell);
+			leave(proj);
 			disable_follower(proj);
 		}
 	}
@@ -502,22 +930,45 @@ namespace Followers
 	{
 		if (proj->IsMissileProjectile() && proj->shooter.get().get() && proj->shooter.get().get()->As<RE::Actor>()) {
 			assert(ind > 0);
-			
+
+			leave(proj);
 			set_follower_ind(proj, ind);
 
 			auto& data = Storage::get_data(ind);
 
-			if (!data.pattern.isShapeless()) {
-				// TODO: optimize for MC
-				auto new_ind = get_unused_shape_ind(proj);
-				if (new_ind == -1 || new_ind >= Storage::get_data(ind).pattern.getSize())
-					new_ind = 0;
+			if (data.compact) {
+				join_compact(proj, ind);
+			} else if (!data.pattern.isShapeless()) {
+				auto new_ind = Slots::acquire(proj, ind, data.pattern.getSize());
+				set_follower_owns_slot(proj, new_ind != -1);
+				if (new_ind == -1)
+					new_ind = 0;  // all are occupied, share the first one
 
 				set_follower_shape_ind(proj, new_ind);
 			}
 		}
 	}
 
+	void on_apply_gravity(RE::Projectile* proj, RE::NiPoint3* dV, float dtime) { Moving::change_direction(proj, dV, dtime); }
+
+	// Killed follower leaves its formation
+	void on_destroyed(RE::Projectile* proj)
+	{
+		if (is_follower(proj)) {
+			leave(proj);
+			disable_follower(proj);
+		}
+	}
+
+	void set_lod(const LODSettings& settings) { LOD::set(settings); }
+	void update(float dtime)
+	{
+		LOD::update();
+		Sleep::update();
+		Moving::Batch::update(dtime);
+		Separation::update();
+	}
+
 	void install()
 	{
 		using namespace Hooks;
@@ -526,7 +977,21 @@ namespace Followers
 	}
 
 	void clear_keys() { Storage::clear_keys(); }
-	void clear() { Storage::clear(); }
+	void clear()
+	{
+		Storage::clear();
+		Slots::clear();
+		Sleep::clear();
+		Moving::Batch::clear();
+		Separation::clear();
+	}
+	void reset()
+	{
+		Slots::clear();
+		Sleep::clear();
+		Moving::Batch::clear();
+		Separation::clear();
+	}
 
 	void init(const std::string& filename, const Json::Value& json_root)
 	{
@@ -13,13 +13,37 @@ namespace Followers
 	void install();
 	void clear();
 	void clear_keys();
+	void reset();  // game is loaded
 	void init(const std::string& filename, const Json::Value& json_root);
 	void init_keys(const std::string& filename, const Json::Value& json_root);
 	uint32_t get_key_ind(const std::string& filename, const std::string& key);
+	// Name of the index that stays the same between sessions, ind is a valid index
+	const std::string& get_key_name(uint32_t ind);
+	// Index of a name from get_key_name, 0 if there is no such name
+	uint32_t find_key_ind(const std::string& name);
 	void apply(RE::Projectile* proj, uint32_t ind);
 	void disable(RE::Projectile* proj, bool restore_speed = true);
 	RE::COL_LAYER layer2layer(Collision l);
 
+	// Followers of casters far from the camera or unseen are updated every few frames
+	struct LODSettings
+	{
+		bool enabled;
+		float near_dist;        // closer casters are updated every frame
+		float far_dist;         // farther casters are updated every far_interval frames
+		uint32_t mid_interval;  // frames between updates, between near and far
+		uint32_t far_interval;  // frames between updates, far or unseen
+		bool snap_far;          // far followers jump to their slots instead of moving
+	};
+	void set_lod(const LODSettings& settings);
+
+	// Called once per frame in the main thread
+	void update(float dtime);
+
+	// From shared hooks, for followers
+	void on_apply_gravity(RE::Projectile* proj, RE::NiPoint3* dV, float dtime);
+	void on_destroyed(RE::Projectile* proj);
+
 	using forEachRes = RE::BSContainer::ForEachResult;
 	using forEachF = std::function<forEachRes(RE::Projectile* proj)>;
 	void forEachFollower(RE::TESObjectREFR* a, const forEachF& func);
@@ -62,6 +62,8 @@ namespace Homing
 		static const auto& get_data(uint32_t ind) { return data_static[ind - 1]; }
 
 		static uint32_t get_key_ind(const std::string& filename, const std::string& key) { return keys.get(filename, key); }
+		static const std::string& get_key_name(uint32_t ind) { return keys.get_name(ind); }
+		static uint32_t find_key_ind(const std::string& name) { return keys.find(name); }
 
 	private:
 		static void read_json_entry(const std::string& filename, const std::string& key, const Json::Value& item)
@@ -108,6 +110,8 @@ namespace Homing
 	const Data& get_data(uint32_t ind) { return Storage::get_data(ind); }
 
 	uint32_t get_key_ind(const std::string& filename, const std::string& key) { return Storage::get_key_ind(filename, key); }
+	const std::string& get_key_name(uint32_t ind) { return Storage::get_key_name(ind); }
+	uint32_t find_key_ind(const std::string& name) { return Storage::find_key_ind(name); }
 
 	void set_homing_ind(RE::Projectile* proj, uint32_t ind) { ::set_homing_ind(proj, ind); }
 	uint32_t get_homing_ind(RE::Projectile* proj) { return ::get_homing_ind(proj); }
@@ -516,29 +520,6 @@ namespace Homing
 			static inline REL::Relocation<decltype(ShouldUseDesiredTarget)> _ShouldUseDesiredTarget;
 		};
 
-		// Make projectile move to the target
-		class HomingMissilesHook
-		{
-		public:
-			static void Hook()
-			{
-				_Projectile__ApplyGravity = SKSE::GetTrampoline().write_call<5>(REL::ID(43006).address() + 0x69,
-					change_direction);  // SkyrimSE.exe+751309
-			}
-
-		private:
-			static bool change_direction(RE::Projectile* proj, RE::NiPoint3* dV, float dtime)
-			{
-				bool ans = _Projectile__ApplyGravity(proj, dV, dtime);
-				if (is_homing(proj)) {
-					Moving::change_direction(proj, dV, dtime);
-				}
-				return ans;
-			}
-
-			static inline REL::Relocation<decltype(change_direction)> _Projectile__ApplyGravity;
-		};
-
 #ifdef DEBUG
 		namespace Debug
 		{
@@ -696,12 +677,14 @@ namespace Homing
 		}
 	}
 
+	// Make projectile move to the target
+	void on_apply_gravity(RE::Projectile* proj, RE::NiPoint3* dV, float dtime) { Moving::change_direction(proj, dV, dtime); }
+
 	void install()
 	{
 		using namespace Hooks;
 
 		HomingFlamesHook::Hook();
-		HomingMissilesHook::Hook();
 
 #ifdef DEBUG
 		Debug::CursorDetectedHook::Hook();
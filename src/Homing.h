@@ -8,12 +8,19 @@ namespace Homing
 	void apply(RE::Projectile* proj, uint32_t ind, RE::Actor* targetOverride);
 	void disable(RE::Projectile* proj);
 
+	// From shared hooks, for homing projectiles
+	void on_apply_gravity(RE::Projectile* proj, RE::NiPoint3* dV, float dtime);
+
 	void install();
 	void init(const std::string& filename, const Json::Value& json_root);
 	void init_keys(const std::string& filename, const Json::Value& json_root);
 	void clear();
 	void clear_keys();
 	uint32_t get_key_ind(const std::string& filename, const std::string& key);
+	// Name of the index that stays the same between sessions, ind is a valid index
+	const std::string& get_key_name(uint32_t ind);
+	// Index of a name from get_key_name, 0 if there is no such name
+	uint32_t find_key_ind(const std::string& name);
 
 	// For MC
 	std::vector<RE::Actor*> get_targets(uint32_t homingInd, RE::TESObjectREFR* caster, const RE::NiPoint3& origin_pos);
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "RuntimeData.h"
+#include "Triggers.h"
+#include "TriggerFunctions.h"
+#include "Followers.h"
+#include "Emitters.h"
+#include "Homing.h"
 
 namespace Hooks
 {
-	// Create proj & load from save with zero padding value
-	// TODO: replace load part to serialization
+	// Create proj & load from save with zero padding value, the state is restored from the co-save (see Serialization)
 	class PaddingsProjectileHook
 	{
 	public:
@@ -154,9 +158,91 @@ namespace Hooks
 				ldata->autoAim = false;
 			}
 
-			return _BeamProjectile__ctor(proj, ldata);
+			auto ans = _BeamProjectile__ctor(proj, ldata);
+			cache_flags(ans);
+			return ans;
 		}
 
 		static inline REL::Relocation<decltype(Ctor)> _BeamProjectile__ctor;
 	};
+
+	// Call sites used by several features. The state of the projectile is read once and routed to them
+
+	// Make homing projectiles move to the target and followers follow the caster
+	class ApplyGravityHook
+	{
+	public:
+		static void Hook()
+		{
+			_Projectile__ApplyGravity = SKSE::GetTrampoline().write_call<5>(REL::ID(43006).address() + 0x69,
+				ApplyGravity);  // SkyrimSE.exe+751309
+		}
+
+	private:
+		static bool ApplyGravity(RE::Projectile* proj, RE::NiPoint3* dV, float dtime)
+		{
+			bool ans = _Projectile__ApplyGravity(proj, dV, dtime);
+
+			auto roles = get_roles(proj);
+			if (roles.homing)
+				Homing::on_apply_gravity(proj, dV, dtime);
+			if (roles.follower)
+				Followers::on_apply_gravity(proj, dV, dtime);
+
+			return ans;
+		}
+
+		static inline REL::Relocation<decltype(ApplyGravity)> _Projectile__ApplyGravity;
+	};
+
+	// ProjDestroyed triggers, then features forget the projectile
+	class KillHook
+	{
+	public:
+		static void Hook()
+		{
+			_ClearFollowedObject = SKSE::GetTrampoline().write_call<5>(REL::ID(42930).address() + 0x21,
+				ClearFollowedObject);  // SkyrimSE.exe+74BC21 Proj::Kill
+		}
+
+	private:
+		static void ClearFollowedObject(RE::BSSoundHandle* shandle)
+		{
+			auto proj = (RE::Projectile*)((char*)shandle - 0x128);
+
+			Triggers::on_destroyed(proj);
+
+			auto roles = get_roles(proj);
+			if (roles.follower)
+				Followers::on_destroyed(proj);
+			if (roles.emitter)
+				Emitters::on_destroyed(proj);
+			clear_extra_data(proj);
+
+			_ClearFollowedObject(shandle);
+		}
+
+		static inline REL::Relocation<decltype(ClearFollowedObject)> _ClearFollowedObject;
+	};
+
+	// Called once per frame in the main thread
+	class UpdateHook
+	{
+	public:
+		static void Hook() { _Update = REL::Relocation<uintptr_t>(RE::VTABLE_PlayerCharacter[0]).write_vfunc(0xad, Update); }
+
+	private:
+		static void Update(RE::PlayerCharacter* a, float delta)
+		{
+			_Update(a, delta);
+
+			Triggers::update(delta);
+			TriggerFunctions::update();
+			Followers::update(delta);
+			Emitters::update(delta);
+			sweep_extra_data();
+		}
+
+		static inline REL::Relocation<decltype(Update)> _Update;
+	};
 }
@@ -33,9 +33,14 @@ namespace JsonUtils
 	class KeysMap
 	{
 		std::unordered_map<std::string, uint32_t> keys;
+		std::vector<std::string> names;  // filename + key, by index - 1
 
 	public:
-		void clear() { keys.clear(); }
+		void clear()
+		{
+			keys.clear();
+			names.clear();
+		}
 
 		// `key` must present and starts with "key_"
 		auto get(const std::string& filename, const std::string& key)
@@ -52,7 +57,18 @@ namespace JsonUtils
 			assert(found == keys.end());
 			uint32_t new_key = static_cast<uint32_t>(keys.size()) + 1;
 			keys.insert({ finalkey, new_key });
+			names.push_back(std::move(finalkey));
 			return new_key;
 		}
+
+		// Stays the same between sessions, unlike the index
+		const std::string& get_name(uint32_t ind) const { return names[ind - 1]; }
+
+		// By name from get_name, 0 if there is no such key
+		uint32_t find(const std::string& name) const
+		{
+			auto found = keys.find(name);
+			return found == keys.end() ? 0 : found->second;
+		}
 	};
 }
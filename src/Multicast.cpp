@@ -3,6 +3,7 @@
 #include "Triggers.h"
 #include "Homing.h"
 #include "Positioning.h"
+#include "RuntimeData.h"
 #include <random>
 
 namespace Multicast
@@ -158,6 +159,7 @@ namespace Multicast
 		{
 			clear_keys();
 			data.clear();
+			names.clear();
 		}
 
 		static void init(const std::string& filename, const Json::Value& MulticastData)
@@ -175,6 +177,7 @@ namespace Multicast
 		}
 
 		static const auto& get_data(uint32_t ind) { return data[ind - 1]; }
+		static const auto& get_name(uint32_t ind) { return names[ind - 1]; }
 
 		static uint32_t get_key_ind(const std::string& filename, const std::string& key) { return keys.get(filename, key); }
 
@@ -184,6 +187,7 @@ namespace Multicast
 			[[maybe_unused]] uint32_t ind = get_key_ind(filename, key);
 			assert(ind == data.size() + 1);
 
+			names.push_back(filename + "/" + key);
 			data.push_back(std::vector<Data>());
 			auto& new_data = data.back();
 
@@ -236,10 +240,108 @@ namespace Multicast
 
 		static inline JsonUtils::KeysMap keys;
 		static inline std::vector<std::vector<Data>> data;
+		static inline std::vector<std::string> names;  // for logging
 	};
 
 	uint32_t get_key_ind(const std::string& filename, const std::string& key) { return Storage::get_key_ind(filename, key); }
 
+	// Projectiles launched here may launch new ones (callTriggers, emitters).
+	// Limits depth of such chains and number of projectiles launched by one cast.
+	class Cascade
+	{
+		struct Root
+		{
+			uint32_t descendants;
+			uint32_t reported: 1;
+			std::chrono::steady_clock::time_point last;
+		};
+
+		static inline uint32_t max_depth = 8;            // 0 for unlimited
+		static inline uint32_t max_descendants = 2000;  // 0 for unlimited
+
+		static inline uint32_t last_root = 0;
+		static inline std::unordered_map<uint32_t, Root> roots;
+		static inline std::mutex lock;
+
+		// Forget casts that have not launched anything for a while
+		static void prune()
+		{
+			constexpr size_t MAX_ROOTS = 1024;
+			constexpr auto TTL = std::chrono::seconds(30);
+
+			if (roots.size() < MAX_ROOTS)
+				return;
+
+			auto now = std::chrono::steady_clock::now();
+			std::erase_if(roots, [now, TTL](const auto& item) { return now - item.second.last > TTL; });
+		}
+
+		static void report(Root& root, uint32_t ind, const char* reason)
+		{
+			if (!root.reported) {
+				root.reported = true;
+				logger::warn("Multicast {} stopped: {}", Storage::get_name(ind), reason);
+			}
+		}
+
+	public:
+		static void set_limits(uint32_t depth, uint32_t descendants)
+		{
+			max_depth = depth;
+			max_descendants = descendants;
+		}
+
+		// Root and depth for projectiles launched from `parent`. False if the chain is too deep
+		static bool enter(RE::Projectile* parent, uint32_t ind, uint32_t& root, uint32_t& depth)
+		{
+			if (!parent || !get_cascade(parent, root, depth)) {
+				root = 0;
+				depth = 0;
+			}
+			depth++;
+
+			std::lock_guard guard(lock);
+
+			if (root == 0) {
+				prune();
+				root = ++last_root;
+				if (root == 0)
+					root = ++last_root;
+			}
+
+			auto& root_data = roots[root];
+			root_data.last = std::chrono::steady_clock::now();
+
+			if (max_depth && depth > max_depth) {
+				report(root_data, ind, "cascade is too deep");
+				return false;
+			}
+			return true;
+		}
+
+		// Counts a new projectile of the chain. False if too many
+		static bool launch(uint32_t root, uint32_t ind)
+		{
+			std::lock_guard guard(lock);
+
+			auto& root_data = roots[root];
+			if (max_descendants && root_data.descendants >= max_descendants) {
+				report(root_data, ind, "too many projectiles launched by one cast");
+				return false;
+			}
+			root_data.descendants++;
+			return true;
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			roots.clear();
+		}
+	};
+
+	void set_cascade_limits(uint32_t depth, uint32_t descendants) { Cascade::set_limits(depth, descendants); }
+
 	namespace Sounds
 	{
 		RE::BGSSoundDescriptorForm* EffectSetting__get_sndr(RE::EffectSetting* a1, RE::MagicSystem::SoundID sid)
@@ -492,8 +594,40 @@ namespace Multicast
 			return handle;
 		}
 		
+		// Homing::Evenly and ToTarget support, targets are shuffled
+		std::vector<RE::ActorHandle> get_targets(const Data& data, RE::TESObjectREFR* caster, const RE::NiPoint3& start_pos)
+		{
+			uint32_t homingInd = SpawnGroupStorage::get_data(data.pattern_ind).rotation_target;
+			if (!homingInd)
+				homingInd = data.functions.get_homing_ind(false);
+
+			if (!homingInd)
+				homingInd = data.functions.get_homing_ind(true);
+
+			// homingInd may be 0 for ToTarget
+			if (!homingInd)
+				return {};
+
+			auto targets = Homing::get_targets(homingInd, caster, start_pos);
+
+			std::random_device rd;
+			std::mt19937 g(rd());
+			std::shuffle(targets.begin(), targets.end(), g);
+
+			std::vector<RE::ActorHandle> ans;
+			ans.reserve(targets.size());
+			for (auto target : targets) {
+				ans.push_back(target->GetHandle());
+			}
+			return ans;
+		}
+
 		// SP_CD has info about cast. Copied, because every SP has info itself.
-		void multiCastGroup(CastData SP_CD, const Data& data, RE::TESObjectREFR* origin, RE::TESObjectREFR* caster)
+		// Launches projectiles [first, first + count) of the group
+		// Targets are of the whole group, the part takes them from `first`
+		void multiCastGroup(CastData SP_CD, const Data& data, RE::TESObjectREFR* origin, RE::TESObjectREFR* caster,
+			uint32_t first, uint32_t count, uint32_t ind, uint32_t root, uint32_t depth,
+			const std::vector<RE::ActorHandle>& targets)
 		{
 			const auto& spellarrow_data = data.origin_formIDs;
 
@@ -539,36 +673,22 @@ namespace Multicast
 			RE::NiPoint3 cast_dir = pattern_data.pattern.getCastDir(SP_CD.parallel_rot);
 			cast_dir.Unitize();
 
-			// Homing::Evenly and ToTarget support
-			std::vector<RE::Actor*> targets;
-			uint32_t homingInd = pattern_data.rotation_target;
-			if (!homingInd)
-				homingInd = data.functions.get_homing_ind(false);
-
-			if (!homingInd)
-				homingInd = data.functions.get_homing_ind(true);
-
-			// homingInd may be 0 for ToTarget
-			if (homingInd) {
-				targets = Homing::get_targets(homingInd, caster, SP_CD.start_pos);
-
-				std::random_device rd;
-				std::mt19937 g(rd());
-				std::shuffle(targets.begin(), targets.end(), g);
-			}
-
 			bool needsound_every = pattern_data.sound == SoundType::Every;
 			bool needsound_single = type == 0 && pattern_data.sound == SoundType::Single;
-			size_t target_ind = 0;
+			size_t target_ind = targets.empty() ? 0 : first % targets.size();
 
 			Positioning::Plane plane(SP_CD.start_pos, cast_dir);
-			for (size_t i = 0; i < pattern_data.pattern.getSize(); i++) {
+			size_t last = std::min<size_t>(pattern_data.pattern.getSize(), static_cast<size_t>(first) + count);
+			for (size_t i = first; i < last; i++) {
 				auto point = pattern_data.pattern.GetPosition(plane, cast_dir, i);
 
+				if (!Cascade::launch(root, ind))
+					return;
+
 				RE::Actor* target = nullptr;
 
 				if (targets.size()) {
-					target = targets[target_ind++];
+					target = targets[target_ind++].get().get();
 					if (target_ind >= targets.size())
 						target_ind = 0;
 				}
@@ -577,6 +697,8 @@ namespace Multicast
 					caster, target);
 
 				if (auto proj = handle.get().get()) {
+					set_cascade(proj, root, depth);
+
 					if (data.call_triggers) {
 						Triggers::Data ldata(proj);
 						Triggers::eval(&ldata, Triggers::Event::ProjAppeared, proj, target);
@@ -588,7 +710,28 @@ namespace Multicast
 		}
 	}
 	
-	void apply(Triggers::Data* ldata, uint32_t ind)
+	uint32_t get_count(uint32_t ind)
+	{
+		uint32_t ans = 0;
+		for (const auto& spawn_data : Storage::get_data(ind)) {
+			ans += SpawnGroupStorage::get_data(spawn_data.pattern_ind).pattern.getSize();
+		}
+		return ans;
+	}
+
+	bool prepare(Triggers::Data* ldata, uint32_t ind, Cast& cast)
+	{
+		if (!Cascade::enter(ldata->proj, ind, cast.root, cast.depth))
+			return false;
+
+		cast.targets.clear();
+		for (const auto& spawn_data : Storage::get_data(ind)) {
+			cast.targets.push_back(Casting::get_targets(spawn_data, ldata->shooter, ldata->pos));
+		}
+		return true;
+	}
+
+	void apply(Triggers::Data* ldata, uint32_t ind, const Cast& cast, uint32_t first, uint32_t count)
 	{
 		using namespace Casting;
 
@@ -622,8 +765,22 @@ namespace Multicast
 		}
 
 		auto& data = Storage::get_data(ind);
-		for (const auto& spawn_data : data) {
-			multiCastGroup(current_CD, spawn_data, ldata->shooter, ldata->shooter);
+		for (size_t i = 0; i < data.size() && i < cast.targets.size(); i++) {
+			const auto& spawn_data = data[i];
+			if (count == 0)
+				break;
+
+			uint32_t size = SpawnGroupStorage::get_data(spawn_data.pattern_ind).pattern.getSize();
+			if (first >= size) {
+				first -= size;
+				continue;
+			}
+
+			uint32_t cur_count = std::min(count, size - first);
+			multiCastGroup(current_CD, spawn_data, ldata->shooter, ldata->shooter, first, cur_count, ind, cast.root,
+				cast.depth, cast.targets[i]);
+			first = 0;
+			count -= cur_count;
 		}
 	}
 
@@ -638,6 +795,7 @@ namespace Multicast
 	{
 		SpawnGroupStorage::clear();
 		Storage::clear();
+		Cascade::clear();
 	}
 
 	void init(const std::string& filename, const Json::Value& json_root)
@@ -4,11 +4,27 @@ struct Ldata;
 
 namespace Multicast
 {
-	void apply(Triggers::Data* ldata, uint32_t ind);
+	// Found once for a cast, shared by all its parts
+	struct Cast
+	{
+		uint32_t root;   // place of the cast in a chain of casts launched by triggers
+		uint32_t depth;
+		std::vector<std::vector<RE::ActorHandle>> targets;  // shuffled, of each spawn group
+	};
+	// False if the chain is too deep
+	bool prepare(Triggers::Data* ldata, uint32_t ind, Cast& cast);
+
+	// Launches projectiles [first, first + count) of all spawn groups
+	void apply(Triggers::Data* ldata, uint32_t ind, const Cast& cast, uint32_t first, uint32_t count);
+	// Total number of projectiles launched by apply
+	uint32_t get_count(uint32_t ind);
 	void install();
 	void init(const std::string& filename, const Json::Value& json_root);
 	void clear();
 	void clear_keys();
 	void init_keys(const std::string& filename, const Json::Value& json_root);
 	uint32_t get_key_ind(const std::string& filename, const std::string& key);
+
+	// Max generation of projectiles launched by triggers, max projectiles launched by one cast. 0 for unlimited
+	void set_cascade_limits(uint32_t depth, uint32_t descendants);
 }
@@ -2,39 +2,39 @@
 
 namespace Positioning
 {
-	RE::NiPoint3 Pattern::GetPosition_Single(const Plane& plane, size_t) const { return plane.startPos; }
-	RE::NiPoint3 Pattern::GetPosition_Line(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_Single(const Plane& plane, size_t, uint32_t) const { return plane.startPos; }
+	RE::NiPoint3 Pattern::GetPosition_Line(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		if (count == 1) {
+		if (n == 1) {
 			return plane.startPos;
 		}
 
 		auto from = plane.startPos - plane.right_dir * (size * 0.5f);
-		float d = size / (count - 1);
+		float d = size / (n - 1);
 		return from + (plane.right_dir * (d * ind));
 	}
-	RE::NiPoint3 Pattern::GetPosition_Circle(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_Circle(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		float alpha = 2 * 3.1415926f / count * ind;
+		float alpha = 2 * 3.1415926f / n * ind;
 		return plane.startPos + (plane.right_dir * cos(alpha) + plane.up_dir * sin(alpha)) * size;
 	}
-	RE::NiPoint3 Pattern::GetPosition_HalfCircle(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_HalfCircle(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		if (count == 1) {
+		if (n == 1) {
 			return plane.startPos;
 		}
 
-		float alpha = 3.1415926f / (count - 1) * ind;
+		float alpha = 3.1415926f / (n - 1) * ind;
 		return plane.startPos + (plane.right_dir * cos(alpha) + plane.up_dir * sin(alpha)) * size;
 	}
-	RE::NiPoint3 Pattern::GetPosition_FillSquare(const Plane& plane, size_t _ind) const
+	RE::NiPoint3 Pattern::GetPosition_FillSquare(const Plane& plane, size_t _ind, uint32_t n) const
 	{
-		if (count == 1) {
+		if (n == 1) {
 			return plane.startPos;
 		}
 
-		uint32_t m = static_cast<uint32_t>(sqrt(count));
-		uint32_t rest = count - m * m;
+		uint32_t m = static_cast<uint32_t>(sqrt(n));
+		uint32_t rest = n - m * m;
 		bool has_right = rest >= m;
 		bool has_up = rest != 0 && rest != m;
 
@@ -44,7 +44,7 @@ namespace Positioning
 		float dx = size / (w - 1);
 		float dy = h == 1 ? 0 : size / (h - 1);
 
-		uint32_t ind = _ind % count;
+		uint32_t ind = _ind % n;
 
 		if (ind < w * m) {
 			uint32_t x = ind % w;
@@ -61,17 +61,17 @@ namespace Positioning
 			return from + plane.right_dir * (dx * x);
 		}
 	}
-	RE::NiPoint3 Pattern::GetPosition_FillCircle(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_FillCircle(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		float c = size / sqrtf(static_cast<float>(count));
+		float c = size / sqrtf(static_cast<float>(n));
 		auto alpha = 2.3999632297286533222f * ind;
 		float r = c * sqrtf(static_cast<float>(ind));
 
 		return plane.startPos + (plane.right_dir * cos(alpha) + plane.up_dir * sin(alpha)) * r;
 	}
-	RE::NiPoint3 Pattern::GetPosition_FillHalfCircle(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_FillHalfCircle(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		float c = size / sqrtf(static_cast<float>(count));
+		float c = size / sqrtf(static_cast<float>(n));
 		float alpha = 0.5f * 2.3999632297286533222f * ind;
 		const float pi = 3.141592653589793f;
 		while (alpha >= 2 * pi)
@@ -81,15 +81,15 @@ namespace Positioning
 		float r = c * sqrtf(static_cast<float>(ind));
 		return plane.startPos + (plane.right_dir * cos(alpha) + plane.up_dir * sin(alpha)) * r;
 	}
-	RE::NiPoint3 Pattern::GetPosition_Sphere(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_Sphere(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		if (count == 1) {
+		if (n == 1) {
 			return plane.startPos;
 		}
 
 		float c = size;
 		float phi = 3.883222077450933f;
-		float y = 1 - (ind / (count - 1.0f)) * 2;
+		float y = 1 - (ind / (n - 1.0f)) * 2;
 		float radius = sqrt(1 - y * y);
 		float theta = phi * ind;
 		float x = cos(theta) * radius;
@@ -99,15 +99,15 @@ namespace Positioning
 
 		return plane.startPos + (plane.right_dir * x + plane.up_dir * z + forward_dir * y) * c;
 	}
-	RE::NiPoint3 Pattern::GetPosition_HalfSphere(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_HalfSphere(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		if (count == 1) {
+		if (n == 1) {
 			return plane.startPos;
 		}
 
 		float c = size;
 		float phi = 3.883222077450933f;
-		float z = 1 - (ind / (count - 1.0f));
+		float z = 1 - (ind / (n - 1.0f));
 		float radius = sqrt(1 - z * z);
 		float theta = phi * ind;
 		float x = cos(theta) * radius;
@@ -117,15 +117,15 @@ namespace Positioning
 
 		return plane.startPos + (plane.right_dir * x + plane.up_dir * z + forward_dir * y) * c;
 	}
-	RE::NiPoint3 Pattern::GetPosition_Cylinder(const Plane& plane, size_t ind) const
+	RE::NiPoint3 Pattern::GetPosition_Cylinder(const Plane& plane, size_t ind, uint32_t n) const
 	{
-		if (count == 1) {
+		if (n == 1) {
 			return plane.startPos;
 		}
 
 		float c = size;
 		float phi = 3.883222077450933f;
-		float y = 1 - (ind / (count - 1.0f)) * 2;
+		float y = 1 - (ind / (n - 1.0f)) * 2;
 		float theta = phi * ind;
 		float x = cos(theta);
 		float z = sin(theta);
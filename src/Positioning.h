@@ -89,16 +89,16 @@ namespace Positioning
 		float rotate_alpha;        // 1C rotate everything along the plane normal
 		RE::NiPoint3 pos_offset;   // 20 offset of SP center from actual cast pos
 
-		RE::NiPoint3 GetPosition_Single(const Plane& plane, size_t) const;
-		RE::NiPoint3 GetPosition_Line(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_Circle(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_HalfCircle(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_FillSquare(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_FillCircle(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_FillHalfCircle(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_Sphere(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_HalfSphere(const Plane& plane, size_t ind) const;
-		RE::NiPoint3 GetPosition_Cylinder(const Plane& plane, size_t) const;
+		RE::NiPoint3 GetPosition_Single(const Plane& plane, size_t, uint32_t n) const;
+		RE::NiPoint3 GetPosition_Line(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_Circle(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_HalfCircle(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_FillSquare(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_FillCircle(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_FillHalfCircle(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_Sphere(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_HalfSphere(const Plane& plane, size_t ind, uint32_t n) const;
+		RE::NiPoint3 GetPosition_Cylinder(const Plane& plane, size_t, uint32_t n) const;
 
 		// Rotate point of the figure
 		RE::NiPoint3 rotateFigure(const RE::NiPoint3& P, const RE::NiPoint3& O, const RE::NiPoint3& axis) const
@@ -109,43 +109,46 @@ namespace Positioning
 			return P;
 		}
 
-		RE::NiPoint3 GetPosition_(const Plane& plane, size_t ind) const
+		RE::NiPoint3 GetPosition_(const Plane& plane, size_t ind, uint32_t n) const
 		{
 			switch (shape) {
 			case Positioning::Shape::Line:
-				return GetPosition_Line(plane, ind);
+				return GetPosition_Line(plane, ind, n);
 			case Positioning::Shape::Circle:
-				return GetPosition_Circle(plane, ind);
+				return GetPosition_Circle(plane, ind, n);
 			case Positioning::Shape::HalfCircle:
-				return GetPosition_HalfCircle(plane, ind);
+				return GetPosition_HalfCircle(plane, ind, n);
 			case Positioning::Shape::FillSquare:
-				return GetPosition_FillSquare(plane, ind);
+				return GetPosition_FillSquare(plane, ind, n);
 			case Positioning::Shape::FillCircle:
-				return GetPosition_FillCircle(plane, ind);
+				return GetPosition_FillCircle(plane, ind, n);
 			case Positioning::Shape::FillHalfCircle:
-				return GetPosition_FillHalfCircle(plane, ind);
+				return GetPosition_FillHalfCircle(plane, ind, n);
 			case Positioning::Shape::Sphere:
-				return GetPosition_Sphere(plane, ind);
+				return GetPosition_Sphere(plane, ind, n);
 			case Positioning::Shape::HalfSphere:
-				return GetPosition_HalfSphere(plane, ind);
+				return GetPosition_HalfSphere(plane, ind, n);
 			case Positioning::Shape::Cylinder:
-				return GetPosition_Cylinder(plane, ind);
+				return GetPosition_Cylinder(plane, ind, n);
 			case Positioning::Shape::Single:
 			case Positioning::Shape::Total:
 			default:
-				return GetPosition_Single(plane, ind);
+				return GetPosition_Single(plane, ind, n);
 			}
 		}
 
 	public:
-		RE::NiPoint3 GetPosition(const RE::NiPoint3& start_pos, const RE::NiPoint3& cast_dir, size_t ind) const
+		// `layout_count` overrides count of the figure, e.g. for a smaller formation
+		RE::NiPoint3 GetPosition(const RE::NiPoint3& start_pos, const RE::NiPoint3& cast_dir, size_t ind,
+			uint32_t layout_count = 0) const
 		{
-			return rotateFigure(GetPosition_(Plane(start_pos, cast_dir), ind), start_pos, cast_dir);
+			return rotateFigure(GetPosition_(Plane(start_pos, cast_dir), ind, layout_count ? layout_count : count), start_pos,
+				cast_dir);
 		}
 
-		RE::NiPoint3 GetPosition(const Plane& plane, const RE::NiPoint3& cast_dir, size_t ind) const
+		RE::NiPoint3 GetPosition(const Plane& plane, const RE::NiPoint3& cast_dir, size_t ind, uint32_t layout_count = 0) const
 		{
-			return rotateFigure(GetPosition_(plane, ind), plane.startPos, cast_dir);
+			return rotateFigure(GetPosition_(plane, ind, layout_count ? layout_count : count), plane.startPos, cast_dir);
 		}
 
 		std::vector<RE::NiPoint3> GetPositions(const RE::NiPoint3& start_pos, const RE::NiPoint3& cast_dir) const
@@ -0,0 +1,145 @@
+#include "RoundingBatch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace RoundingBatch
+{
+	namespace
+	{
+		constexpr float CIRCLE_K = 0.01f;
+		constexpr float CIRCLE_K_BIG = 1.0f + CIRCLE_K;
+		constexpr float CIRCLE_K_SML = 1.0f - CIRCLE_K;
+		constexpr float EPS = 1e-6f;
+		constexpr float ANGLE_EPS = 1e-4f;
+	}
+
+	void Arrays::clear()
+	{
+		for (auto arr : { &px, &py, &pz, &vx, &vy, &vz, &tx, &ty, &tz, &cx, &cy, &cz, &radius, &dtime, &nx, &ny, &nz })
+			arr->clear();
+		sphere.clear();
+	}
+
+	void Arrays::reserve(size_t n)
+	{
+		for (auto arr : { &px, &py, &pz, &vx, &vy, &vz, &tx, &ty, &tz, &cx, &cy, &cz, &radius, &dtime, &nx, &ny, &nz })
+			arr->reserve(n);
+		sphere.reserve(n);
+	}
+
+	void Arrays::add(const Vec& pos, const Vec& vel, const Vec& target, const Vec& cast_dir, float R, float dt, bool is_sphere)
+	{
+		px.push_back(pos.x), py.push_back(pos.y), pz.push_back(pos.z);
+		vx.push_back(vel.x), vy.push_back(vel.y), vz.push_back(vel.z);
+		tx.push_back(target.x), ty.push_back(target.y), tz.push_back(target.z);
+		cx.push_back(cast_dir.x), cy.push_back(cast_dir.y), cz.push_back(cast_dir.z);
+		radius.push_back(R);
+		dtime.push_back(dt);
+		sphere.push_back(is_sphere);
+	}
+
+	// All three cases are computed for every follower, then one of them is selected,
+	// so the loop has no branches and the compiler may vectorize it
+	void integrate(Arrays& arrays)
+	{
+		auto n = arrays.size();
+		arrays.nx.resize(n), arrays.ny.resize(n), arrays.nz.resize(n);
+
+		const float* px = arrays.px.data();
+		const float* py = arrays.py.data();
+		const float* pz = arrays.pz.data();
+		const float* vx = arrays.vx.data();
+		const float* vy = arrays.vy.data();
+		const float* vz = arrays.vz.data();
+		const float* tx = arrays.tx.data();
+		const float* ty = arrays.ty.data();
+		const float* tz = arrays.tz.data();
+		const float* cx = arrays.cx.data();
+		const float* cy = arrays.cy.data();
+		const float* cz = arrays.cz.data();
+		const float* radius = arrays.radius.data();
+		const float* dtime = arrays.dtime.data();
+		const uint8_t* sphere = arrays.sphere.data();
+		float* nx = arrays.nx.data();
+		float* ny = arrays.ny.data();
+		float* nz = arrays.nz.data();
+
+		for (size_t i = 0; i < n; i++) {
+			float dx = px[i] - tx[i], dy = py[i] - ty[i], dz = pz[i] - tz[i];
+			float speed = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+			float L = speed * dtime[i];  // path of the frame
+			float R = std::max(radius[i], EPS);
+			float R2 = R * R;
+
+			// Axis: Sphere rounds in the plane of velocity and target, cast dir if they are parallel. Plane rounds cast dir
+			float sx = dy * vz[i] - dz * vy[i], sy = dz * vx[i] - dx * vz[i], sz = dx * vy[i] - dy * vx[i];
+			float s_len = std::sqrt(sx * sx + sy * sy + sz * sz);
+			bool own_axis = sphere[i] && s_len > EPS;
+			float inv_s = 1.0f / std::max(s_len, EPS);
+			float ax = own_axis ? sx * inv_s : cx[i];
+			float ay = own_axis ? sy * inv_s : cy[i];
+			float az = own_axis ? sz * inv_s : cz[i];
+
+			// Offset from the target: h along the axis, e in the plane
+			float h = ax * dx + ay * dy + az * dz;
+			float ex = dx - ax * h, ey = dy - ay * h, ez = dz - az * h;
+			float D2 = std::max(ex * ex + ey * ey + ez * ez, EPS);
+			float D = std::sqrt(D2);
+
+			// Tangent in the plane along the motion, |q| = D
+			float qx = ay * ez - az * ey, qy = az * ex - ax * ez, qz = ax * ey - ay * ex;
+			float dir = qx * vx[i] + qy * vy[i] + qz * vz[i] < 0 ? -1.0f : 1.0f;
+			qx *= dir, qy *= dir, qz *= dir;
+
+			// Out of circle: to the tangent point T, the rest of the path along the circle
+			float a = R2 / D2;
+			float b = R / D2 * std::sqrt(std::max(D2 - R2, 0.0f));
+			float Tx = ex * a + qx * b, Ty = ey * a + qy * b, Tz = ez * a + qz * b;  // from the target
+			float Vx = tx[i] + Tx - px[i], Vy = ty[i] + Ty - py[i], Vz = tz[i] + Tz - pz[i];
+			float len = std::sqrt(Vx * Vx + Vy * Vy + Vz * Vz);
+			float rest = L - len;
+			float k_line = L / std::max(len, EPS);
+			float phi_out = std::max(rest, 0.0f) / R;
+			float cos_out = std::cos(phi_out), sin_out = std::sin(phi_out);
+			// tangent at T, |U| = |T|
+			float Ux = dir * (ay * Tz - az * Ty), Uy = dir * (az * Tx - ax * Tz), Uz = dir * (ax * Ty - ay * Tx);
+			bool on_line = rest <= 0;
+			float out_x = on_line ? px[i] + Vx * k_line : tx[i] + Tx * cos_out + Ux * sin_out;
+			float out_y = on_line ? py[i] + Vy * k_line : ty[i] + Ty * cos_out + Uy * sin_out;
+			float out_z = on_line ? pz[i] + Vz * k_line : tz[i] + Tz * cos_out + Uz * sin_out;
+
+			// Inside of circle: turn velocity to the tangent by at most L / R
+			float inv_speed = 1.0f / std::max(speed, EPS);
+			float ux = vx[i] * inv_speed, uy = vy[i] * inv_speed, uz = vz[i] * inv_speed;
+			float inv_D = 1.0f / D;
+			float wx = qx * inv_D, wy = qy * inv_D, wz = qz * inv_D;
+			float theta = std::acos(std::clamp(ux * wx + uy * wy + uz * wz, -1.0f, 1.0f));
+			float turn = std::min(L / R, theta);
+			float inv_sin = 1.0f / std::max(std::sin(theta), EPS);
+			bool aligned = theta < ANGLE_EPS;
+			float k_cur = aligned ? 1.0f : std::sin(theta - turn) * inv_sin;
+			float k_tan = aligned ? 0.0f : std::sin(turn) * inv_sin;
+			float fx = ux * k_cur + wx * k_tan, fy = uy * k_cur + wy * k_tan, fz = uz * k_cur + wz * k_tan;
+			float k_in = L / std::max(std::sqrt(fx * fx + fy * fy + fz * fz), EPS);
+			float in_x = px[i] + fx * k_in, in_y = py[i] + fy * k_in, in_z = pz[i] + fz * k_in;
+
+			// On circle: along it, Plane also moves to its plane by dh
+			float H = std::abs(h);
+			float t = L > H + ANGLE_EPS ? std::min(1.0f, H / std::sqrt(std::max(L * L - H * H, EPS))) : 1.0f;
+			float dl = L / std::sqrt(1.0f + t * t);
+			float dh = h > 0 ? -dl * t : dl * t;
+			float phi_on = dl / R;
+			float cos_on = std::cos(phi_on), sin_on = std::sin(phi_on);
+			float on_x = tx[i] + ax * (h + dh) + ex * cos_on + qx * sin_on;
+			float on_y = ty[i] + ay * (h + dh) + ey * cos_on + qy * sin_on;
+			float on_z = tz[i] + az * (h + dh) + ez * cos_on + qz * sin_on;
+
+			bool out = D2 > R2 * CIRCLE_K_BIG * CIRCLE_K_BIG;
+			bool in = D2 < R2 * CIRCLE_K_SML * CIRCLE_K_SML;
+			bool still = speed < EPS;
+			nx[i] = still ? px[i] : out ? out_x : in ? in_x : on_x;
+			ny[i] = still ? py[i] : out ? out_y : in ? in_y : on_y;
+			nz[i] = still ? pz[i] : out ? out_z : in ? in_z : on_z;
+		}
+	}
+}
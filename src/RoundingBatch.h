@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Next positions of rounding followers, all of them in one branchless loop over contiguous arrays.
+// Does not use the game, tools/followers_bench runs it too.
+namespace RoundingBatch
+{
+	struct Vec
+	{
+		float x, y, z;
+	};
+
+	struct Arrays
+	{
+		// inputs
+		std::vector<float> px, py, pz;  // position
+		std::vector<float> vx, vy, vz;  // velocity
+		std::vector<float> tx, ty, tz;  // target point
+		std::vector<float> cx, cy, cz;  // cast dir, for Plane
+		std::vector<float> radius;
+		std::vector<float> dtime;
+		std::vector<uint8_t> sphere;  // Sphere if 1, else Plane
+
+		// outputs: next position
+		std::vector<float> nx, ny, nz;
+
+		size_t size() const { return px.size(); }
+		void clear();
+		void reserve(size_t n);
+		void add(const Vec& pos, const Vec& vel, const Vec& target, const Vec& cast_dir, float R, float dt, bool is_sphere);
+		Vec get(size_t i) const { return { nx[i], ny[i], nz[i] }; }
+	};
+
+	// Sphere: rounds the target in the plane of velocity. Plane: rounds the axis of cast dir, moving to its plane.
+	// Out of circle: goes to a tangent point, then along the circle. Inside: turns velocity to the tangent.
+	// On circle: goes along it. Zero velocity stays
+	void integrate(Arrays& arrays);
+}
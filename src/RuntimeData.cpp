@@ -1,59 +1,456 @@
 #include "RuntimeData.h"
+#include <atomic>
+#include <shared_mutex>
 
-struct FenixProjsRuntimeData
+// pad164 of a projectile: a key of its record in the side table (low 30 bits) and cached flags (high 2 bits)
+namespace Pad
 {
-	void set_NormalType() { (uint32_t&)data = 0; }
+	constexpr uint32_t KEY_MASK = (1u << 30) - 1;
+	constexpr uint32_t FLAGS_KNOWN = 1u << 30;  // flags are evaluated
+	constexpr uint32_t MULTIPLE_BEAMS = 1u << 31;
 
-	struct Indexes
+	std::atomic_ref<uint32_t> get(RE::Projectile* proj) { return std::atomic_ref<uint32_t>((uint32_t&)proj->pad164); }
+}
+
+// Per-projectile state lives in a side table. Key of a record is
+// slot index + 1 in the low bits and generation of the slot in the high ones, 0 for none
+namespace Records
+{
+	struct Record
 	{
-		uint32_t homing: 6;
-		uint32_t emitter: 6;
-		uint32_t emitter_rest: 5;
-		uint32_t follower: 6;
-		uint32_t follower_shape_ind: 8;
-		uint32_t unused: 1;
+		RE::Projectile* owner;  // checked on every access, together with formID
+		RE::FormID formID;
+		RE::ProjectileHandle handle;  // to find records of projectiles that are gone
+
+		uint32_t homing;
+		uint32_t emitter;
+		uint32_t emitter_rest;
+		uint32_t follower;
+		uint32_t follower_shape_ind;
+		bool follower_owns_slot;
+
+		bool has_cascade;
+		uint32_t cascade_root;
+		uint32_t cascade_depth;
+
+		PendingInit pending;
 	};
-	static_assert(sizeof(Indexes) == 4);
 
-	void set_homing_ind(uint32_t ind) { data.homing = ind; }
-	uint32_t get_homing_ind() { return data.homing; }
+	class Storage
+	{
+		static constexpr uint32_t INDEX_BITS = 20;  // ~1M projectiles at once
+		static constexpr uint32_t INDEX_MASK = (1 << INDEX_BITS) - 1;
+		static constexpr uint32_t GENERATION_MASK = Pad::KEY_MASK >> INDEX_BITS;
 
-	void set_emitter_ind(uint32_t ind) { data.emitter = ind; }
-	uint32_t get_emitter_ind() { return data.emitter; }
-	void set_emitter_rest(uint32_t count) { data.emitter_rest = count; }
-	uint32_t get_emitter_rest() { return data.emitter_rest; }
+		struct Slot
+		{
+			uint32_t dense;
+			uint32_t generation;
+		};
 
-	void set_follower_ind(uint32_t ind) { data.follower = ind; }
-	uint32_t get_follower_ind() { return data.follower; }
-	void set_follower_shape_ind(uint32_t ind) { data.follower_shape_ind = ind; }
-	uint32_t get_follower_shape_ind() { return data.follower_shape_ind; }
+		static inline std::shared_mutex lock;
+		static inline std::vector<Record> records;      // dense, iterated by sweep
+		static inline std::vector<uint32_t> record_slot;  // slot of each record
+		static inline std::vector<Slot> slots;
+		static inline std::vector<uint32_t> free_slots;
 
-	Indexes data;
-};
-static_assert(sizeof(FenixProjsRuntimeData) == 4);
+		static uint32_t get_key(RE::Projectile* proj) { return Pad::get(proj).load(std::memory_order_relaxed) & Pad::KEY_MASK; }
 
-FenixProjsRuntimeData& get_runtime_data(RE::Projectile* proj) { return (FenixProjsRuntimeData&)(uint32_t&)proj->pad164; }
+		// Keeps the flags
+		static void set_key(RE::Projectile* proj, uint32_t key)
+		{
+			auto pad = Pad::get(proj);
+			auto old = pad.load(std::memory_order_relaxed);
+			while (!pad.compare_exchange_weak(old, (old & ~Pad::KEY_MASK) | key, std::memory_order_relaxed)) {}
+		}
 
-void init_NormalType(RE::Projectile* proj) { get_runtime_data(proj).set_NormalType(); }
+		static Record* find(RE::Projectile* proj, uint32_t key)
+		{
+			uint32_t slot = (key & INDEX_MASK) - 1;
+			if (slot >= slots.size() || slots[slot].generation != (key >> INDEX_BITS))
+				return nullptr;
 
-void set_homing_ind(RE::Projectile* proj, uint32_t ind) { get_runtime_data(proj).set_homing_ind(ind); }
-uint32_t get_homing_ind(RE::Projectile* proj) { return get_runtime_data(proj).get_homing_ind(); }
+			auto& record = records[slots[slot].dense];
+			return record.owner == proj && record.formID == proj->formID ? &record : nullptr;
+		}
 
-void set_emitter_ind(RE::Projectile* proj, uint32_t ind) { get_runtime_data(proj).set_emitter_ind(ind); }
-uint32_t get_emitter_ind(RE::Projectile* proj) { return get_runtime_data(proj).get_emitter_ind(); }
-void set_emitter_rest(RE::Projectile* proj, uint32_t count) { get_runtime_data(proj).set_emitter_rest(count); }
-uint32_t get_emitter_rest(RE::Projectile* proj) { return get_runtime_data(proj).get_emitter_rest(); }
+		static void erase(uint32_t slot)
+		{
+			auto dense = slots[slot].dense;
+			if (dense + 1 != records.size()) {
+				records[dense] = std::move(records.back());
+				record_slot[dense] = record_slot.back();
+				slots[record_slot[dense]].dense = dense;
+			}
+			records.pop_back();
+			record_slot.pop_back();
 
-void set_follower_ind(RE::Projectile* proj, uint32_t ind) { get_runtime_data(proj).set_follower_ind(ind); }
-uint32_t get_follower_ind(RE::Projectile* proj) { return get_runtime_data(proj).get_follower_ind(); }
-void set_follower_shape_ind(RE::Projectile* proj, uint32_t ind) { get_runtime_data(proj).set_follower_shape_ind(ind); }
-uint32_t get_follower_shape_ind(RE::Projectile* proj) { return get_runtime_data(proj).get_follower_shape_ind(); }
+			slots[slot].generation = (slots[slot].generation + 1) & GENERATION_MASK;
+			free_slots.push_back(slot);
+		}
 
-bool allows_multiple_beams(RE::Projectile* proj)
+	public:
+		// Copy of the record, zeroes if there is none
+		static Record get(RE::Projectile* proj)
+		{
+			auto key = get_key(proj);
+			if (!key)
+				return {};
+
+			std::shared_lock guard(lock);
+			auto record = find(proj, key);
+			return record ? *record : Record{};
+		}
+
+		// Changes the record. Makes it if needed, unless the change is a reset
+		template <typename F>
+		static void update(RE::Projectile* proj, bool reset, F func)
+		{
+			auto key = get_key(proj);
+			if (!key && reset)
+				return;
+
+			std::unique_lock guard(lock);
+
+			auto record = key ? find(proj, key) : nullptr;
+			if (!record) {
+				if (reset)
+					return;
+
+				uint32_t slot;
+				if (!free_slots.empty()) {
+					slot = free_slots.back();
+					free_slots.pop_back();
+				} else if (slots.size() < INDEX_MASK) {
+					slot = static_cast<uint32_t>(slots.size());
+					slots.push_back({ 0, 0 });
+				} else {
+					logger::error("Too many projectiles with runtime data");
+					return;
+				}
+
+				slots[slot].dense = static_cast<uint32_t>(records.size());
+				record_slot.push_back(slot);
+				record = &records.emplace_back(Record{ proj, proj->formID, RE::ProjectileHandle(proj) });
+				set_key(proj, (slots[slot].generation << INDEX_BITS) | (slot + 1));
+			}
+
+			func(*record);
+		}
+
+		static void remove(RE::Projectile* proj)
+		{
+			auto key = get_key(proj);
+			if (!key)
+				return;
+
+			std::unique_lock guard(lock);
+			if (find(proj, key))
+				erase((key & INDEX_MASK) - 1);
+			set_key(proj, 0);
+		}
+
+		template <typename F>
+		static void for_each(F func)
+		{
+			std::shared_lock guard(lock);
+			for (const auto& record : records) {
+				func(record);
+			}
+		}
+
+		// Forget records of projectiles that are gone without being killed
+		static void sweep()
+		{
+			std::unique_lock guard(lock);
+			for (size_t i = records.size(); i-- > 0;) {
+				auto& record = records[i];
+				auto proj = record.handle.get().get();
+				if (proj != record.owner || !proj || proj->formID != record.formID)
+					erase(record_slot[i]);
+			}
+		}
+
+		static void clear()
+		{
+			std::unique_lock guard(lock);
+			records.clear();
+			record_slot.clear();
+			slots.clear();
+			free_slots.clear();
+		}
+	};
+}
+
+namespace Registry
+{
+	// Projectiles having some role, by shooter. A projectile is in lists of the shooter it had when got its first role
+	class Storage
+	{
+		struct Entry
+		{
+			RE::ProjectileHandle handle;
+			RE::FormID shooter;
+			uint32_t roles;
+		};
+
+		using Lists = std::array<std::vector<RE::ProjectileHandle>, (size_t)Role::Total>;
+
+		static inline std::mutex lock;
+		static inline std::unordered_map<RE::FormID, Entry> projs;
+		static inline std::unordered_map<RE::FormID, Lists> shooters;
+
+		static void erase(RE::FormID shooter, Role role, RE::ProjectileHandle handle)
+		{
+			auto found = shooters.find(shooter);
+			if (found == shooters.end())
+				return;
+
+			auto& list = found->second[(size_t)role];
+			if (auto it = std::find(list.begin(), list.end(), handle); it != list.end()) {
+				*it = list.back();
+				list.pop_back();
+			}
+
+			if (std::all_of(found->second.begin(), found->second.end(), [](const auto& list) { return list.empty(); }))
+				shooters.erase(found);
+		}
+
+		static void erase(std::unordered_map<RE::FormID, Entry>::iterator entry)
+		{
+			for (uint32_t role = 0; role < (uint32_t)Role::Total; role++) {
+				if (entry->second.roles & (1 << role))
+					erase(entry->second.shooter, (Role)role, entry->second.handle);
+			}
+			projs.erase(entry);
+		}
+
+	public:
+		static void update(RE::Projectile* proj, Role role, bool has)
+		{
+			std::lock_guard guard(lock);
+
+			RE::ProjectileHandle handle(proj);
+			auto found = projs.find(proj->formID);
+
+			// formID is reused by a new projectile
+			if (found != projs.end() && found->second.handle != handle) {
+				erase(found);
+				found = projs.end();
+			}
+
+			uint32_t mask = 1 << (uint32_t)role;
+			if (has) {
+				if (found == projs.end()) {
+					auto shooter = proj->shooter.get().get();
+					found = projs.insert({ proj->formID, { handle, shooter ? shooter->formID : 0, 0 } }).first;
+				}
+
+				if (!(found->second.roles & mask)) {
+					found->second.roles |= mask;
+					shooters[found->second.shooter][(size_t)role].push_back(handle);
+				}
+			} else if (found != projs.end() && (found->second.roles & mask)) {
+				found->second.roles &= ~mask;
+				erase(found->second.shooter, role, handle);
+				if (!found->second.roles)
+					projs.erase(found);
+			}
+		}
+
+		static void remove(RE::Projectile* proj)
+		{
+			std::lock_guard guard(lock);
+
+			if (auto found = projs.find(proj->formID); found != projs.end())
+				erase(found);
+		}
+
+		// Forget projectiles that are gone without being killed
+		static void sweep()
+		{
+			std::lock_guard guard(lock);
+
+			for (auto it = projs.begin(); it != projs.end();) {
+				auto cur = it++;
+				auto proj = cur->second.handle.get().get();
+				if (!proj || proj->formID != cur->first)
+					erase(cur);
+			}
+		}
+
+		static std::vector<RE::ProjectileHandle> get(RE::TESObjectREFR* shooter, Role role)
+		{
+			std::lock_guard guard(lock);
+
+			auto found = shooters.find(shooter->formID);
+			return found == shooters.end() ? std::vector<RE::ProjectileHandle>() : found->second[(size_t)role];
+		}
+
+		static std::vector<RE::ProjectileHandle> get_all(Role role)
+		{
+			std::lock_guard guard(lock);
+
+			std::vector<RE::ProjectileHandle> ans;
+			for (const auto& [shooter, lists] : shooters) {
+				const auto& list = lists[(size_t)role];
+				ans.insert(ans.end(), list.begin(), list.end());
+			}
+			return ans;
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			projs.clear();
+			shooters.clear();
+		}
+	};
+
+	std::vector<RE::ProjectileHandle> get(RE::TESObjectREFR* shooter, Role role) { return Storage::get(shooter, role); }
+	std::vector<RE::ProjectileHandle> get_all(Role role) { return Storage::get_all(role); }
+}
+
+void init_NormalType(RE::Projectile* proj) { Pad::get(proj).store(0, std::memory_order_relaxed); }
+
+void set_homing_ind(RE::Projectile* proj, uint32_t ind)
+{
+	Records::Storage::update(proj, ind == 0, [ind](auto& record) { record.homing = ind; });
+	Registry::Storage::update(proj, Registry::Role::Homing, ind != 0);
+}
+uint32_t get_homing_ind(RE::Projectile* proj) { return Records::Storage::get(proj).homing; }
+
+void set_emitter_ind(RE::Projectile* proj, uint32_t ind)
+{
+	Records::Storage::update(proj, ind == 0, [ind](auto& record) { record.emitter = ind; });
+	Registry::Storage::update(proj, Registry::Role::Emitter, ind != 0);
+}
+uint32_t get_emitter_ind(RE::Projectile* proj) { return Records::Storage::get(proj).emitter; }
+void set_emitter_rest(RE::Projectile* proj, uint32_t count)
+{
+	Records::Storage::update(proj, count == 0, [count](auto& record) { record.emitter_rest = count; });
+}
+uint32_t get_emitter_rest(RE::Projectile* proj) { return Records::Storage::get(proj).emitter_rest; }
+
+void set_follower_ind(RE::Projectile* proj, uint32_t ind)
+{
+	Records::Storage::update(proj, ind == 0, [ind](auto& record) { record.follower = ind; });
+	Registry::Storage::update(proj, Registry::Role::Follower, ind != 0);
+}
+uint32_t get_follower_ind(RE::Projectile* proj) { return Records::Storage::get(proj).follower; }
+void set_follower_shape_ind(RE::Projectile* proj, uint32_t ind)
+{
+	Records::Storage::update(proj, ind == 0, [ind](auto& record) { record.follower_shape_ind = ind; });
+}
+uint32_t get_follower_shape_ind(RE::Projectile* proj) { return Records::Storage::get(proj).follower_shape_ind; }
+void set_follower_owns_slot(RE::Projectile* proj, bool owns)
+{
+	Records::Storage::update(proj, !owns, [owns](auto& record) { record.follower_owns_slot = owns; });
+}
+bool get_follower_owns_slot(RE::Projectile* proj) { return Records::Storage::get(proj).follower_owns_slot; }
+
+Roles get_roles(RE::Projectile* proj)
+{
+	auto record = Records::Storage::get(proj);
+	return { record.homing, record.emitter, record.follower };
+}
+
+void set_cascade(RE::Projectile* proj, uint32_t root, uint32_t depth)
+{
+	Records::Storage::update(proj, false, [root, depth](auto& record) {
+		record.has_cascade = true;
+		record.cascade_root = root;
+		record.cascade_depth = depth;
+	});
+}
+
+bool get_cascade(RE::Projectile* proj, uint32_t& root, uint32_t& depth)
+{
+	auto record = Records::Storage::get(proj);
+	root = record.cascade_root;
+	depth = record.cascade_depth;
+	return record.has_cascade;
+}
+
+void add_pending_speed(RE::Projectile* proj, float mul, float add)
+{
+	Records::Storage::update(proj, false, [mul, add](auto& record) {
+		auto& pending = record.pending;
+		pending.speed = true;
+		pending.speed_mul *= mul;
+		pending.speed_add = pending.speed_add * mul + add;
+	});
+}
+
+void set_pending_layer(RE::Projectile* proj, RE::COL_LAYER layer)
+{
+	Records::Storage::update(proj, false, [layer](auto& record) {
+		record.pending.layer = true;
+		record.pending.col_layer = layer;
+	});
+}
+
+PendingInit take_pending_init(RE::Projectile* proj)
+{
+	auto ans = Records::Storage::get(proj).pending;
+	if (ans.speed || ans.layer)
+		Records::Storage::update(proj, true, [](auto& record) { record.pending = {}; });
+	return ans;
+}
+
+void clear_extra_data(RE::Projectile* proj)
+{
+	Registry::Storage::remove(proj);
+	Records::Storage::remove(proj);
+}
+
+void clear_extra_data()
+{
+	Registry::Storage::clear();
+	Records::Storage::clear();
+}
+
+void sweep_extra_data()
+{
+	constexpr uint32_t SWEEP_FRAMES = 600;
+	static uint32_t frame = 0;
+
+	if (++frame % SWEEP_FRAMES)
+		return;
+
+	Records::Storage::sweep();
+	Registry::Storage::sweep();
+}
+
+std::vector<SavedState> get_saved_states()
+{
+	std::vector<SavedState> ans;
+	Records::Storage::for_each([&ans](const Records::Record& record) {
+		if ((record.homing || record.emitter || record.follower) && record.handle.get().get() == record.owner)
+			ans.push_back({ record.formID, record.homing, record.emitter, record.emitter_rest, record.follower });
+	});
+	return ans;
+}
+
+void cache_flags(RE::Projectile* proj)
 {
 	auto spell = proj->spell;
-	return spell && spell->GetCastingType() == RE::MagicSystem::CastingType::kFireAndForget && proj->IsBeamProjectile() &&
-	       proj->flags.all(RE::Projectile::Flags::kUseOrigin) && !proj->flags.any(RE::Projectile::Flags::kAutoAim);
+	bool multiple_beams = spell && spell->GetCastingType() == RE::MagicSystem::CastingType::kFireAndForget &&
+	                      proj->IsBeamProjectile() && proj->flags.all(RE::Projectile::Flags::kUseOrigin) &&
+	                      !proj->flags.any(RE::Projectile::Flags::kAutoAim);
+
+	Pad::get(proj).fetch_or(Pad::FLAGS_KNOWN | (multiple_beams ? Pad::MULTIPLE_BEAMS : 0), std::memory_order_relaxed);
+}
+
+bool allows_multiple_beams(RE::Projectile* proj)
+{
+	auto pad = Pad::get(proj).load(std::memory_order_relaxed);
+	if (!(pad & Pad::FLAGS_KNOWN)) {
+		// loaded from a save
+		cache_flags(proj);
+		pad = Pad::get(proj).load(std::memory_order_relaxed);
+	}
+	return pad & Pad::MULTIPLE_BEAMS;
 }
 
 bool allows_detach_beam(RE::MagicItem* spel)
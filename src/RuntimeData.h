@@ -2,6 +2,9 @@
 
 void init_NormalType(RE::Projectile* proj);
 
+// Evaluates predicates below once, they are cached in the projectile. Called when a beam is created,
+// for other projectiles when first asked
+void cache_flags(RE::Projectile* proj);
 bool allows_multiple_beams(RE::Projectile* proj);
 bool allows_detach_beam(RE::MagicItem* proj);
 void set_homing_ind(RE::Projectile* proj, uint32_t ind);
@@ -16,3 +19,69 @@ void set_follower_ind(RE::Projectile* proj, uint32_t ind);
 uint32_t get_follower_ind(RE::Projectile* proj);
 void set_follower_shape_ind(RE::Projectile* proj, uint32_t ind);
 uint32_t get_follower_shape_ind(RE::Projectile* proj);
+void set_follower_owns_slot(RE::Projectile* proj, bool owns);  // shape ind is marked as occupied in caster's slots
+bool get_follower_owns_slot(RE::Projectile* proj);
+
+// Projectiles launched by triggers: the cast that started the chain and a generation in it
+void set_cascade(RE::Projectile* proj, uint32_t root, uint32_t depth);
+bool get_cascade(RE::Projectile* proj, uint32_t& root, uint32_t& depth);
+
+// Changes of a projectile made before it is inited, applied at once when it computes its velocity
+struct PendingInit
+{
+	bool speed = false;  // new speed = speed * speed_mul + speed_add
+	float speed_mul = 1.0f;
+	float speed_add = 0.0f;
+	bool layer = false;
+	RE::COL_LAYER col_layer = RE::COL_LAYER::kUnidentified;
+};
+void add_pending_speed(RE::Projectile* proj, float mul, float add);  // after pending ones
+void set_pending_layer(RE::Projectile* proj, RE::COL_LAYER layer);
+// Returns and forgets pending changes. No lookup for vanilla projectiles
+PendingInit take_pending_init(RE::Projectile* proj);
+
+// Indexes of configs of a projectile, 0 for none. Read at once for hooks that route to several features,
+// no lookup for vanilla projectiles
+struct Roles
+{
+	uint32_t homing;
+	uint32_t emitter;
+	uint32_t follower;
+};
+Roles get_roles(RE::Projectile* proj);
+
+// Projectiles having homing, emitter or follower state, by shooter. Updated when the state is set or reset
+namespace Registry
+{
+	enum class Role : uint32_t
+	{
+		Homing,
+		Emitter,
+		Follower,
+
+		Total
+	};
+
+	// Copy, so the state may be changed while iterating. Handles may be invalid already
+	std::vector<RE::ProjectileHandle> get(RE::TESObjectREFR* shooter, Role role);
+	// Of all shooters
+	std::vector<RE::ProjectileHandle> get_all(Role role);
+}
+
+// State of a projectile that goes to saves: indexes of configs, 0 for none
+struct SavedState
+{
+	RE::FormID formID;
+	uint32_t homing;
+	uint32_t emitter;
+	uint32_t emitter_rest;
+	uint32_t follower;
+};
+std::vector<SavedState> get_saved_states();
+
+// Projectile is killed, forget its data
+void clear_extra_data(RE::Projectile* proj);
+void clear_extra_data();
+
+// Forget data of projectiles that are gone without being killed. Called once per frame
+void sweep_extra_data();
@@ -0,0 +1,207 @@
+#include "Serialization.h"
+#include "RuntimeData.h"
+#include "Homing.h"
+#include "Emitters.h"
+#include "Followers.h"
+
+namespace Serialization
+{
+	constexpr uint32_t ID = 'FNPR';
+	constexpr uint32_t STATES = 'PSTA';
+	constexpr uint32_t VERSION = 1;
+
+	// STATES, version 1:
+	//   u32 names count, then for each: u8 role, u32 index, u32 length, chars of the name
+	//   u32 states count, then for each: u32 formID, u32 homing, u32 emitter, u32 emitter_rest, u32 follower
+	// Indexes are of the session that saved, they are mapped to the current ones by names
+
+	enum class Role : uint8_t
+	{
+		Homing,
+		Emitter,
+		Follower
+	};
+
+	const std::string& get_key_name(Role role, uint32_t ind)
+	{
+		switch (role) {
+		case Role::Homing:
+			return Homing::get_key_name(ind);
+		case Role::Emitter:
+			return Emitters::get_key_name(ind);
+		case Role::Follower:
+		default:
+			return Followers::get_key_name(ind);
+		}
+	}
+
+	uint32_t find_key_ind(Role role, const std::string& name)
+	{
+		switch (role) {
+		case Role::Homing:
+			return Homing::find_key_ind(name);
+		case Role::Emitter:
+			return Emitters::find_key_ind(name);
+		case Role::Follower:
+			return Followers::find_key_ind(name);
+		default:
+			return 0;
+		}
+	}
+
+	std::vector<SavedState> loaded;  // with current indexes, until the game is loaded
+
+	template <typename T>
+	bool write(SKSE::SerializationInterface* intf, const T& value)
+	{
+		return intf->WriteRecordData(&value, sizeof(T));
+	}
+
+	template <typename T>
+	bool read(SKSE::SerializationInterface* intf, T& value)
+	{
+		return intf->ReadRecordData(&value, sizeof(T)) == sizeof(T);
+	}
+
+	void save(SKSE::SerializationInterface* intf)
+	{
+		auto states = get_saved_states();
+		if (states.empty())
+			return;
+
+		if (!intf->OpenRecord(STATES, VERSION)) {
+			logger::error("Failed to save projectiles state");
+			return;
+		}
+
+		std::vector<std::pair<Role, uint32_t>> names;
+		for (const auto& state : states) {
+			for (auto [role, ind] : { std::pair{ Role::Homing, state.homing }, std::pair{ Role::Emitter, state.emitter },
+					 std::pair{ Role::Follower, state.follower } }) {
+				if (ind && std::find(names.begin(), names.end(), std::pair{ role, ind }) == names.end())
+					names.emplace_back(role, ind);
+			}
+		}
+
+		write(intf, static_cast<uint32_t>(names.size()));
+		for (auto [role, ind] : names) {
+			const auto& name = get_key_name(role, ind);
+			write(intf, role);
+			write(intf, ind);
+			write(intf, static_cast<uint32_t>(name.size()));
+			intf->WriteRecordData(name.data(), static_cast<uint32_t>(name.size()));
+		}
+
+		write(intf, static_cast<uint32_t>(states.size()));
+		for (const auto& state : states) {
+			write(intf, state.formID);
+			write(intf, state.homing);
+			write(intf, state.emitter);
+			write(intf, state.emitter_rest);
+			write(intf, state.follower);
+		}
+	}
+
+	bool read_states(SKSE::SerializationInterface* intf)
+	{
+		std::map<std::pair<Role, uint32_t>, uint32_t> remap;
+
+		uint32_t count;
+		if (!read(intf, count))
+			return false;
+		for (uint32_t i = 0; i < count; i++) {
+			Role role;
+			uint32_t ind, length;
+			if (!read(intf, role) || !read(intf, ind) || !read(intf, length))
+				return false;
+
+			std::string name(length, '\0');
+			if (intf->ReadRecordData(name.data(), length) != length)
+				return false;
+
+			auto new_ind = find_key_ind(role, name);
+			if (!new_ind)
+				logger::warn("Saved projectiles use {}, it is not in configs anymore", name);
+			remap[{ role, ind }] = new_ind;
+		}
+
+		auto get_ind = [&remap](Role role, uint32_t ind) {
+			auto found = remap.find({ role, ind });
+			return found == remap.end() ? 0 : found->second;
+		};
+
+		if (!read(intf, count))
+			return false;
+		for (uint32_t i = 0; i < count; i++) {
+			SavedState state;
+			if (!read(intf, state.formID) || !read(intf, state.homing) || !read(intf, state.emitter) ||
+				!read(intf, state.emitter_rest) || !read(intf, state.follower))
+				return false;
+
+			if (!intf->ResolveFormID(state.formID, state.formID))
+				continue;
+
+			state.homing = get_ind(Role::Homing, state.homing);
+			state.emitter = get_ind(Role::Emitter, state.emitter);
+			state.follower = get_ind(Role::Follower, state.follower);
+			if (state.homing || state.emitter || state.follower)
+				loaded.push_back(state);
+		}
+		return true;
+	}
+
+	void load(SKSE::SerializationInterface* intf)
+	{
+		loaded.clear();
+
+		uint32_t type, version, length;
+		while (intf->GetNextRecordInfo(type, version, length)) {
+			if (type != STATES)
+				continue;
+
+			if (version != VERSION) {
+				logger::warn("Unknown version {} of saved projectiles state, skipped", version);
+				continue;
+			}
+
+			if (!read_states(intf)) {
+				logger::error("Saved projectiles state is broken");
+				loaded.clear();
+			}
+		}
+	}
+
+	void revert(SKSE::SerializationInterface*) { loaded.clear(); }
+
+	void apply_loaded()
+	{
+		for (const auto& state : loaded) {
+			auto refr = RE::TESForm::LookupByID<RE::TESObjectREFR>(state.formID);
+			auto proj = refr ? refr->As<RE::Projectile>() : nullptr;
+			if (!proj)
+				continue;
+
+			if (state.homing)
+				Homing::apply(proj, state.homing, nullptr);
+			if (state.emitter) {
+				Emitters::apply(proj, state.emitter);
+				set_emitter_rest(proj, state.emitter_rest);
+			}
+			if (state.follower)
+				Followers::apply(proj, state.follower);
+		}
+
+		if (!loaded.empty())
+			logger::info("Restored state of {} projectiles", loaded.size());
+		loaded.clear();
+	}
+
+	void install()
+	{
+		auto serialization = SKSE::GetSerializationInterface();
+		serialization->SetUniqueID(ID);
+		serialization->SetSaveCallback(save);
+		serialization->SetLoadCallback(load);
+		serialization->SetRevertCallback(revert);
+	}
+}
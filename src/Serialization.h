@@ -0,0 +1,10 @@
+#pragma once
+
+// Runtime state of projectiles in the SKSE co-save
+namespace Serialization
+{
+	void install();
+
+	// Game is loaded and runtime state is reset, restore the state read from the save
+	void apply_loaded();
+}
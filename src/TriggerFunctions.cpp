@@ -1,12 +1,15 @@
 #include "TriggerFunctions.h"
 
 #include "JsonUtils.h"
+#include "RuntimeData.h"
 
 #include "Homing.h"
 #include "Emitters.h"
 #include "Followers.h"
 #include "Multicast.h"
 #include "Triggers.h"
+#include <unordered_set>
+#include <queue>
 
 namespace TriggerFunctions
 {
@@ -14,12 +17,6 @@ namespace TriggerFunctions
 		type(JsonUtils::read_enum<NumberFunctions>(data, "type")), value(JsonUtils::getFloat(data, "value"))
 	{}
 
-	Function::NumberFunctionData::NumberFunctionData(const RE::NiPoint3& linVel)
-	{
-		memcpy(&type, &linVel.y, 4);
-		value = linVel.z;
-	}
-
 	void Function::eval_SetRotationHoming(RE::Projectile* proj, RE::Actor* targetOverride) const
 	{
 		Homing::applyRotate(proj, ind, targetOverride);
@@ -39,22 +36,25 @@ namespace TriggerFunctions
 	void Function::eval_DisableEmitter(RE::Projectile* proj) const { Emitters::disable(proj); }
 	void Function::eval_SetFollower(RE::Projectile* proj) const { Followers::apply(proj, ind); }
 	void Function::eval_DisableFollower(RE::Projectile* proj) const { Followers::disable(proj, restore_speed); }
-	void Function::eval_ChangeSpeed(RE::Projectile* proj) const
+	void Function::eval_ChangeSpeed(RE::Projectile* proj, uint32_t times) const
 	{
 		if (!proj->flags.any(RE::Projectile::Flags::kInited)) {
-			// x for col_layer
-			assert(proj->linearVelocity.y == 0 && proj->linearVelocity.z == 0);
-
-			memcpy(&proj->linearVelocity.y, &numb.type, 4);
-			proj->linearVelocity.z = numb.value;
+			// velocity is not computed yet
+			float mul, add;
+			numb.get_linear(mul, add, times);
+			add_pending_speed(proj, mul, add);
 		} else {
 			float cur_speed = proj->linearVelocity.Length();
-			float old_speed = numb.apply(cur_speed);
+			float old_speed = numb.apply(cur_speed, times);
 			proj->linearVelocity *= cur_speed / old_speed;
 		}
 	}
-	void Function::eval_ChangeRange(RE::Projectile* proj) const { numb.apply(proj->range); }
-	void Function::eval_ApplyMultiCast(Triggers::Data* data) const { Multicast::apply(data, ind); }
+	void Function::eval_ChangeRange(RE::Projectile* proj, uint32_t times) const { numb.apply(proj->range, times); }
+	void Function::eval_ApplyMultiCast(Triggers::Data* data, const Multicast::Cast& cast, uint32_t first,
+		uint32_t count) const
+	{
+		Multicast::apply(data, ind, cast, first, count);
+	}
 	void Function::eval_Placeatme(Triggers::Data* data) const
 	{
 		RE::TESDataHandler::GetSingleton()->CreateReferenceAtLocation(form->As<RE::TESBoundObject>(), data->pos,
@@ -73,15 +73,301 @@ namespace TriggerFunctions
 	void Function::eval_SetColLayer(RE::Projectile* proj) const
 	{
 		if (!proj->flags.any(RE::Projectile::Flags::kInited)) {
-			// y, z for speed
-			assert(proj->linearVelocity.x == 0);
-
-			memcpy(&proj->linearVelocity.x, &layer, 4);
+			set_pending_layer(proj, layer);
 		} else {
 			FenixUtils::Projectile__set_collision_layer(proj, layer);
 		}
 	}
 
+	// Trigger data with refs stored as handles, to call functions later
+	struct StoredData
+	{
+		Triggers::Data data;
+		RE::ObjectRefHandle shooter;
+		RE::ObjectRefHandle target;
+		RE::ObjectRefHandle data_proj;
+		RE::ObjectRefHandle proj;
+		RE::ObjectRefHandle targetOverride;
+
+		StoredData(Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride) :
+			data(*data), shooter(get_handle(data->shooter)), target(get_handle(data->target)),
+			data_proj(get_handle(data->proj)), proj(get_handle(proj)), targetOverride(get_handle(targetOverride))
+		{}
+
+		// Returns false if shooter or proj disappeared
+		bool restore(RE::Projectile*& proj_, RE::Actor*& targetOverride_)
+		{
+			auto shooter_ = shooter.get();
+			if (shooter && !shooter_)
+				return false;
+
+			auto proj_ref = proj.get();
+			if (proj && !proj_ref)
+				return false;
+
+			auto data_proj_ = data_proj.get();
+			auto targetOverride_ref = targetOverride.get();
+
+			data.shooter = shooter_.get();
+			data.target = target.get().get();
+			data.proj = data_proj_ ? data_proj_->As<RE::Projectile>() : nullptr;
+			proj_ = proj_ref ? proj_ref->As<RE::Projectile>() : nullptr;
+			targetOverride_ = targetOverride_ref ? targetOverride_ref->As<RE::Actor>() : nullptr;
+			return true;
+		}
+
+	private:
+		static RE::ObjectRefHandle get_handle(RE::TESObjectREFR* refr) { return refr ? refr->GetHandle() : RE::ObjectRefHandle(); }
+	};
+
+	// Functions with `deferred` flag, captured during the frame
+	class Deferred
+	{
+		struct Command
+		{
+			const Function* func;
+			StoredData data;
+		};
+
+		// Same function with same args
+		struct Key
+		{
+			const Function* func;
+			RE::TESObjectREFR* shooter;
+			RE::TESObjectREFR* target;
+			RE::Projectile* proj;
+			RE::Actor* targetOverride;
+			float x, y, z;
+
+			bool operator==(const Key&) const = default;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const
+			{
+				size_t ans = std::hash<const void*>()(key.func);
+				for (auto p : { (void*)key.shooter, (void*)key.target, (void*)key.proj, (void*)key.targetOverride }) {
+					ans = ans * 31 + std::hash<void*>()(p);
+				}
+				for (auto f : { key.x, key.y, key.z }) {
+					ans = ans * 31 + std::hash<float>()(f);
+				}
+				return ans;
+			}
+		};
+
+		static constexpr size_t CAPACITY = 256;
+
+		static inline std::vector<Command> queue;
+		static inline std::vector<Command> running;
+		static inline std::unordered_set<Key, KeyHash> added;
+		static inline std::mutex lock;
+
+	public:
+		static void push(const Function* func, Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride)
+		{
+			std::lock_guard guard(lock);
+
+			if (queue.capacity() < CAPACITY) {
+				queue.reserve(CAPACITY);
+				running.reserve(CAPACITY);
+				added.reserve(CAPACITY);
+			}
+
+			if (!added.insert({ func, data->shooter, data->target, proj, targetOverride, data->pos.x, data->pos.y, data->pos.z })
+					 .second)
+				return;
+
+			queue.emplace_back(func, StoredData(data, proj, targetOverride));
+		}
+
+		static void flush()
+		{
+			{
+				std::lock_guard guard(lock);
+				if (queue.empty())
+					return;
+
+				// Functions may add new ones, they are called next frame
+				running.swap(queue);
+				added.clear();
+			}
+
+			for (auto& command : running) {
+				RE::Projectile* proj;
+				RE::Actor* targetOverride;
+				if (command.data.restore(proj, targetOverride)) {
+					command.func->eval_now(&command.data.data, proj, targetOverride);
+				}
+			}
+			running.clear();
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			queue.clear();
+			added.clear();
+		}
+	};
+
+	// Limits work of expensive functions per frame, the rest is carried over to next frames
+	class Budget
+	{
+		struct Job
+		{
+			uint32_t priority;
+			uint64_t seq;    // older first
+			uint32_t first;  // done already
+			uint32_t cost;
+			const Function* func;
+			Multicast::Cast cast;  // of the whole call, not of a part
+			StoredData data;
+		};
+
+		struct JobLess
+		{
+			bool operator()(const Job& a, const Job& b) const
+			{
+				return a.priority < b.priority || (a.priority == b.priority && a.seq > b.seq);
+			}
+		};
+
+		static inline uint32_t max_cost = 0;  // 0 for unlimited
+		static inline float max_ms = 0.0f;    // 0 for unlimited
+
+		static inline uint32_t spent = 0;
+		static inline float spent_ms = 0.0f;
+		static inline uint64_t last_seq = 0;
+		static inline std::priority_queue<Job, std::vector<Job>, JobLess> jobs;
+		static inline std::mutex lock;
+
+		// Counters, logged when queue is drained
+		static inline uint32_t frames_hit = 0;
+		static inline uint32_t jobs_delayed = 0;
+		static inline size_t max_queue = 0;
+
+		static uint32_t available()
+		{
+			if (max_ms > 0 && spent_ms >= max_ms)
+				return 0;
+			if (max_cost == 0)
+				return static_cast<uint32_t>(-1);
+			return spent < max_cost ? max_cost - spent : 0;
+		}
+
+		static void push(Job job)
+		{
+			jobs.push(std::move(job));
+			max_queue = std::max(max_queue, jobs.size());
+		}
+
+		static void run(const Function* func, Triggers::Data* data, const Multicast::Cast& cast, uint32_t first,
+			uint32_t count)
+		{
+			auto start = std::chrono::steady_clock::now();
+			func->eval_expensive(data, cast, first, count);
+			float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			std::lock_guard guard(lock);
+			spent_ms += ms;
+		}
+
+	public:
+		static void set_limits(uint32_t cost, float ms)
+		{
+			std::lock_guard guard(lock);
+			max_cost = cost;
+			max_ms = ms;
+		}
+
+		static void call(const Function* func, Triggers::Data* data, uint32_t priority)
+		{
+			Multicast::Cast cast{};
+			if (!func->start_expensive(data, cast))
+				return;
+
+			uint32_t cost = func->get_cost();
+			uint32_t count = 0;
+			{
+				std::lock_guard guard(lock);
+
+				// Do not overtake queued ones
+				if (jobs.empty()) {
+					count = std::min(available(), cost);
+					spent += count;
+				}
+
+				if (count < cost) {
+					jobs_delayed++;
+					push({ priority, ++last_seq, count, cost, func, cast, StoredData(data, nullptr, nullptr) });
+				}
+			}
+
+			if (count > 0) {
+				run(func, data, cast, 0, count);
+			}
+		}
+
+		// New frame, new budget
+		static void flush()
+		{
+			{
+				std::lock_guard guard(lock);
+				spent = 0;
+				spent_ms = 0;
+				if (jobs.empty())
+					return;
+			}
+
+			while (true) {
+				std::optional<Job> job;
+				uint32_t count;
+				{
+					std::lock_guard guard(lock);
+					count = available();
+					if (jobs.empty() || count == 0)
+						break;
+
+					job.emplace(jobs.top());
+					jobs.pop();
+					count = std::min(count, job->cost - job->first);
+					spent += count;
+				}
+
+				RE::Projectile* proj;
+				RE::Actor* targetOverride;
+				if (!job->data.restore(proj, targetOverride))
+					continue;
+
+				run(job->func, &job->data.data, job->cast, job->first, count);
+
+				if (job->first + count < job->cost) {
+					job->first += count;
+					std::lock_guard guard(lock);
+					push(std::move(*job));
+				}
+			}
+
+			std::lock_guard guard(lock);
+			if (!jobs.empty()) {
+				frames_hit++;
+			} else {
+				logger::info("Budget was hit in {} frames, {} calls delayed, max queue {}", frames_hit, jobs_delayed, max_queue);
+				frames_hit = 0;
+				jobs_delayed = 0;
+				max_queue = 0;
+			}
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			jobs = {};
+		}
+	};
+
 	void Function::eval_impl(Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride) const
 	{
 		switch (type) {
@@ -114,7 +400,7 @@ namespace TriggerFunctions
 				eval_ChangeRange(proj);
 			break;
 		case Type::ApplyMultiCast:
-			eval_ApplyMultiCast(data);
+			Budget::call(this, data, 0);
 			break;
 		case Type::DisableFollower:
 			if (proj)
@@ -129,13 +415,13 @@ namespace TriggerFunctions
 				eval_DisableHoming(proj);
 			break;
 		case Type::Placeatme:
-			eval_Placeatme(data);
+			Budget::call(this, data, 1);
 			break;
 		case Type::SendAnimEvent:
 			eval_SendAnimEvent(data);
 			break;
 		case Type::Explode:
-			eval_Explode(data);
+			Budget::call(this, data, 2);
 			break;
 		case Type::SetColLayer:
 			if (proj)
@@ -146,7 +432,30 @@ namespace TriggerFunctions
 		}
 	}
 
+	void update()
+	{
+		Budget::flush();
+		Deferred::flush();
+	}
+
+	void clear()
+	{
+		Budget::clear();
+		Deferred::clear();
+	}
+
+	void set_budget(uint32_t cost, float ms) { Budget::set_limits(cost, ms); }
+
 	void Function::eval(Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride) const
+	{
+		if (deferred) {
+			Deferred::push(this, data, proj, targetOverride);
+		} else {
+			eval_now(data, proj, targetOverride);
+		}
+	}
+
+	void Function::eval_now(Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride) const
 	{
 		if (on_follower) {
 			Followers::forEachFollower(data->shooter, [this, data, targetOverride](RE::Projectile* proj_follower) {
@@ -160,6 +469,66 @@ namespace TriggerFunctions
 		}
 	}
 
+	bool Function::eval_batch(const std::vector<RE::Projectile*>& projs, const std::vector<uint32_t>& times) const
+	{
+		if (on_follower || deferred)
+			return false;
+
+		switch (type) {
+		case Type::ChangeSpeed:
+			for (size_t i = 0; i < projs.size(); i++) {
+				eval_ChangeSpeed(projs[i], times[i]);
+			}
+			return true;
+		case Type::ChangeRange:
+			for (size_t i = 0; i < projs.size(); i++) {
+				eval_ChangeRange(projs[i], times[i]);
+			}
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	uint32_t Function::get_repeats(uint32_t times) const
+	{
+		switch (type) {
+		case Type::ChangeSpeed:
+		case Type::ChangeRange:
+		case Type::ApplyMultiCast:
+		case Type::Placeatme:
+		case Type::Explode:
+			return std::min(times, MAX_REPEATS);
+		default:
+			return std::min(times, 1u);
+		}
+	}
+
+	bool Function::start_expensive(Triggers::Data* data, Multicast::Cast& cast) const
+	{
+		return type != Type::ApplyMultiCast || Multicast::prepare(data, ind, cast);
+	}
+
+	void Function::eval_expensive(Triggers::Data* data, const Multicast::Cast& cast, uint32_t first, uint32_t count) const
+	{
+		switch (type) {
+		case Type::ApplyMultiCast:
+			eval_ApplyMultiCast(data, cast, first, count);
+			break;
+		case Type::Placeatme:
+			eval_Placeatme(data);
+			break;
+		case Type::Explode:
+			eval_Explode(data);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+	}
+
+	uint32_t Function::get_cost() const { return type == Type::ApplyMultiCast ? Multicast::get_count(ind) : 1; }
+
 	uint32_t Function::get_homing_ind(bool rotation) const
 	{
 		if (!rotation && type == Type::SetHoming || rotation && type == Type::SetRotationHoming)
@@ -169,7 +538,8 @@ namespace TriggerFunctions
 	}
 
 	Function::Function(const std::string& filename, const Json::Value& function) :
-		type(JsonUtils::read_enum<Type>(function, "type")), on_follower(JsonUtils::mb_read_field<false>(function, "on_followers"))
+		type(JsonUtils::read_enum<Type>(function, "type")), on_follower(JsonUtils::mb_read_field<false>(function, "on_followers")),
+		deferred(JsonUtils::mb_read_field<false>(function, "deferred"))
 	{
 		switch (type) {
 		case Type::SetRotationToSight:
@@ -218,12 +588,8 @@ namespace TriggerFunctions
 		}
 	}
 
-	Function::Function(const RE::NiPoint3& linVel) : type(Type::ChangeSpeed), on_follower(false)
-	{
-		numb = NumberFunctionData(linVel);
-	}
-
-	Function::Function(const Function& other) : type(other.type), on_follower(other.on_follower)
+	Function::Function(const Function& other) :
+		type(other.type), on_follower(other.on_follower), deferred(other.deferred)
 	{
 		if (type == Type::SendAnimEvent) {
 			memset(&event, 0, 8);
@@ -265,4 +631,26 @@ namespace TriggerFunctions
 		Triggers::Data trigger_data(proj);
 		call(&trigger_data, proj, targetOverride);
 	}
+
+	void Functions::call_batch(const std::vector<RE::Projectile*>& projs, const std::vector<uint32_t>& times) const
+	{
+		std::vector<Triggers::Data> trigger_datas;  // made when some function needs them
+		for (const auto& func : functions) {
+			if (func.eval_batch(projs, times))
+				continue;
+
+			if (trigger_datas.empty()) {
+				trigger_datas.reserve(projs.size());
+				for (auto proj : projs) {
+					trigger_datas.emplace_back(proj);
+				}
+			}
+
+			for (size_t i = 0; i < projs.size(); i++) {
+				for (uint32_t repeat = func.get_repeats(times[i]); repeat > 0; repeat--) {
+					func.eval(&trigger_datas[i], projs[i]);
+				}
+			}
+		}
+	}
 }
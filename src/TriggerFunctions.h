@@ -7,6 +7,11 @@ namespace Triggers
 	struct Data;
 }
 
+namespace Multicast
+{
+	struct Cast;
+}
+
 namespace TriggerFunctions
 {
 	struct Function
@@ -33,6 +38,7 @@ namespace TriggerFunctions
 	private:
 		Type type: 8;
 		uint32_t on_follower: 1;
+		uint32_t deferred: 1;  // run once per frame from the main thread
 
 		struct NumberFunctionData
 		{
@@ -46,9 +52,9 @@ namespace TriggerFunctions
 
 			NumberFunctionData() : type(NumberFunctions::Add), value(0) {}
 			explicit NumberFunctionData(const Json::Value& data);
-			explicit NumberFunctionData(const RE::NiPoint3& linVel);  // For ChangeSpeed (triggers only on 3dLoaded)
 
-			float apply(float& val) const
+			// As `times` applies in a row
+			float apply(float& val, uint32_t times = 1) const
 			{
 				float ans = val;
 				switch (type) {
@@ -56,16 +62,39 @@ namespace TriggerFunctions
 					val = value;
 					break;
 				case NumberFunctions::Add:
-					val += value;
+					val += value * static_cast<float>(times);
 					break;
 				case NumberFunctions::Mul:
-					val *= value;
+					val *= std::pow(value, static_cast<float>(times));
 					break;
 				default:
 					break;
 				}
 				return ans;
 			}
+
+			// As val * mul + add, for values that are not known yet
+			void get_linear(float& mul, float& add, uint32_t times = 1) const
+			{
+				switch (type) {
+				case NumberFunctions::Set:
+					mul = 0;
+					add = value;
+					break;
+				case NumberFunctions::Add:
+					mul = 1;
+					add = value * static_cast<float>(times);
+					break;
+				case NumberFunctions::Mul:
+					mul = std::pow(value, static_cast<float>(times));
+					add = 0;
+					break;
+				default:
+					mul = 1;
+					add = 0;
+					break;
+				}
+			}
 		};
 		static_assert(sizeof(NumberFunctionData) == 0x8);
 
@@ -87,9 +116,9 @@ namespace TriggerFunctions
 		void eval_DisableEmitter(RE::Projectile* proj) const;
 		void eval_SetFollower(RE::Projectile* proj) const;
 		void eval_DisableFollower(RE::Projectile* proj) const;
-		void eval_ChangeSpeed(RE::Projectile* proj) const;
-		void eval_ChangeRange(RE::Projectile* proj) const;
-		void eval_ApplyMultiCast(Triggers::Data* data) const;
+		void eval_ChangeSpeed(RE::Projectile* proj, uint32_t times = 1) const;
+		void eval_ChangeRange(RE::Projectile* proj, uint32_t times = 1) const;
+		void eval_ApplyMultiCast(Triggers::Data* data, const Multicast::Cast& cast, uint32_t first, uint32_t count) const;
 		void eval_Placeatme(Triggers::Data* data) const;
 		void eval_SendAnimEvent(Triggers::Data* data) const;
 		void eval_Explode(Triggers::Data* data) const;
@@ -99,11 +128,24 @@ namespace TriggerFunctions
 
 	public:
 		void eval(Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride = nullptr) const;
+		void eval_now(Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride = nullptr) const;
+
+		// For ChangeSpeed, ChangeRange: one loop over all projectiles. False if the function cannot be batched
+		// times[i] is how many calls in a row it is for projs[i]
+		bool eval_batch(const std::vector<RE::Projectile*>& projs, const std::vector<uint32_t>& times) const;
+		static constexpr uint32_t MAX_REPEATS = 16;
+		// Calls to make for `times` calls in a row: launches are repeated, at most MAX_REPEATS, states are set once
+		uint32_t get_repeats(uint32_t times) const;
+
+		// For ApplyMultiCast, Placeatme, Explode. Called within frame budget, maybe by parts.
+		// start_expensive is called once before all parts, false if the call is dropped
+		bool start_expensive(Triggers::Data* data, Multicast::Cast& cast) const;
+		void eval_expensive(Triggers::Data* data, const Multicast::Cast& cast, uint32_t first, uint32_t count) const;
+		uint32_t get_cost() const;
 		uint32_t get_homing_ind(bool rotation) const;
 
-		Function() : type(Type::ChangeSpeed), numb() {}
+		Function() : type(Type::ChangeSpeed), on_follower(false), deferred(false), numb() {}
 		Function(const std::string& filename, const Json::Value& function);
-		explicit Function(const RE::NiPoint3& linVel);  // For ChangeSpeed (triggers only on 3dLoaded)
 		Function(const Function& other);
 
 		~Function()
@@ -131,8 +173,21 @@ namespace TriggerFunctions
 		void call(RE::Projectile* proj, RE::Actor* targetOverride = nullptr) const;
 		void call(Triggers::Data* data, RE::Projectile* proj, RE::Actor* targetOverride) const;
 
+		// Same as call for each of them, function by function. times[i] is how many calls in a row it is for projs[i]:
+		// changes of speed and range are scaled, see Function::get_repeats for the others
+		void call_batch(const std::vector<RE::Projectile*>& projs, const std::vector<uint32_t>& times) const;
+
 		uint32_t get_homing_ind(bool rotation) const;
 
 		bool should_disable_origin() const { return disable_origin; }
 	};
+
+	// Runs delayed and deferred functions
+	void update();
+
+	// Forget deferred functions, they are invalid now
+	void clear();
+
+	// Max launches, explosions and placed objects per frame, max time of them per frame. 0 for unlimited
+	void set_budget(uint32_t cost, float ms);
 }
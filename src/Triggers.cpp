@@ -1,6 +1,8 @@
 #include "Triggers.h"
 #include "TriggerFunctions.h"
 #include "JsonUtils.h"
+#include "Cache.h"
+#include "RuntimeData.h"
 
 namespace Triggers
 {
@@ -27,7 +29,8 @@ namespace Triggers
 			CasterBaseIsFormID,
 			CasterHasKwd,
 			WeaponBaseIsFormID,
-			WeaponHasKwd
+			WeaponHasKwd,
+			HitsAtLeast
 		};
 
 		Type type: 30;
@@ -38,6 +41,8 @@ namespace Triggers
 		{
 			Hand hand;
 			RE::FormID formid;
+			uint32_t bit;   // for CasterHasKwd, EffectsHasKwd, EffectsIsFormID
+			uint32_t hits;  // for HitsAtLeast
 		};
 
 	private:
@@ -48,26 +53,8 @@ namespace Triggers
 			       hand == Hand::Right && (source == Src::kRightHand || source == Src::kInstant || source == Src::kOther);
 		}
 		bool eval_BaseIsFormID(RE::BGSProjectile* bproj) const { return bproj && bproj->formID == formid; }
-		bool eval_EffectsHasKwd(RE::MagicItem* spel) const
-		{
-			if (spel) {
-				for (auto eff : spel->effects) {
-					if (eff->baseEffect->HasKeywordID(formid))
-						return true;
-				}
-			}
-			return false;
-		}
-		bool eval_EffectsIsFormID(RE::MagicItem* spel) const
-		{
-			if (spel) {
-				for (auto eff : spel->effects) {
-					if (eff->baseEffect->formID == formid)
-						return true;
-				}
-			}
-			return false;
-		}
+		bool eval_EffectsHasKwd(RE::MagicItem* spel) const { return spel && Cache::Spells::has_effect_kwd(spel, bit); }
+		bool eval_EffectsIsFormID(RE::MagicItem* spel) const { return spel && Cache::Spells::has_effect(spel, bit); }
 		bool eval_EffectHasKwd(RE::EffectSetting* mgef) const { return mgef ? mgef->HasKeywordID(formid) : false; }
 		bool eval_EffectIsFormID(RE::EffectSetting* mgef) const { return mgef ? mgef->formID == formid : false; }
 		bool eval_SpellHasKwd(RE::MagicItem* spel) const { return spel ? spel->HasKeywordID(formid) : false; }
@@ -81,16 +68,14 @@ namespace Triggers
 		{
 			if (caster_) {
 				if (auto caster = caster_->As<RE::Actor>()) {
-					if (auto kwd = RE::TESForm::LookupByID<RE::BGSKeyword>(formid)) {
-						return caster->HasKeyword(kwd) || (caster->GetActorBase() && caster->GetActorBase()->HasKeyword(kwd)) ||
-						       FenixUtils::TESObjectREFR__HasEffectKeyword(caster, kwd);
-					}
+					return Cache::Keywords::caster_has(caster, bit);
 				}
 			}
 			return false;
 		}
 		bool eval_WeaponBaseIsFormID(RE::TESObjectWEAP* weap) const { return weap && weap->formID == formid; }
 		bool eval_WeaponHasKwd(RE::TESObjectWEAP* weap) const { return weap && weap->HasKeywordID(formid); }
+		bool eval_HitsAtLeast(uint32_t count) const { return count >= hits; }
 
 	public:
 		Condition(const std::string& filename, const Json::Value& json_condition) :
@@ -101,20 +86,29 @@ namespace Triggers
 			case Type::ProjBaseIsFormID:
 			case Type::EffectIsFormID:
 			case Type::EffectHasKwd:
-			case Type::EffectsIsFormID:
-			case Type::EffectsHasKwd:
 			case Type::SpellHasKwd:
 			case Type::SpellIsFormID:
 			case Type::CasterIsFormID:
 			case Type::CasterBaseIsFormID:
-			case Type::CasterHasKwd:
 			case Type::WeaponBaseIsFormID:
 			case Type::WeaponHasKwd:
 				formid = JsonUtils::get_formid(filename, JsonUtils::getString(json_condition, "formID"));
 				break;
+			case Type::CasterHasKwd:
+				bit = Cache::Keywords::add(JsonUtils::get_formid(filename, JsonUtils::getString(json_condition, "formID")));
+				break;
+			case Type::EffectsHasKwd:
+				bit = Cache::Spells::add_effect_kwd(JsonUtils::get_formid(filename, JsonUtils::getString(json_condition, "formID")));
+				break;
+			case Type::EffectsIsFormID:
+				bit = Cache::Spells::add_effect(JsonUtils::get_formid(filename, JsonUtils::getString(json_condition, "formID")));
+				break;
 			case Type::Hand:
 				hand = JsonUtils::read_enum<Hand>(json_condition, "hand");
 				break;
+			case Type::HitsAtLeast:
+				hits = JsonUtils::mb_read_field<1u>(json_condition, "count");
+				break;
 			default:
 				assert(false);
 				break;
@@ -153,6 +147,8 @@ namespace Triggers
 				return eval_EffectsHasKwd(data->spel);
 			case Type::Hand:
 				return eval_Hand(data->hand);
+			case Type::HitsAtLeast:
+				return eval_HitsAtLeast(data->hits);
 			default:
 				assert(false);
 				return false;
@@ -161,11 +157,124 @@ namespace Triggers
 	};
 	static_assert(sizeof(Condition) == 0x8);
 
+	// Last fire times of triggers with cooldown.
+	// Open addressing, expired entries are reused.
+	class Cooldowns
+	{
+		struct Entry
+		{
+			uint64_t key;  // 0 for never used
+			double until;
+		};
+
+		static constexpr uint32_t SIZE = 4096;  // power of 2
+		static constexpr uint32_t MAX_PROBES = 16;
+
+		static inline std::array<Entry, SIZE> table;
+		static inline std::mutex lock;
+		static inline std::atomic<double> clock = 0;  // seconds of game time, stops in menus and pause
+
+		static uint32_t hash(uint64_t key) { return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 52); }
+
+	public:
+		static double now() { return clock.load(std::memory_order_relaxed); }
+
+		// Called once per frame in the main thread
+		static void advance(float dtime) { clock.store(now() + dtime, std::memory_order_relaxed); }
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			table.fill({});
+		}
+
+		static bool is_ready(uint64_t key, double now)
+		{
+			std::lock_guard guard(lock);
+
+			uint32_t h = hash(key);
+			for (uint32_t i = 0; i < MAX_PROBES; i++) {
+				const auto& entry = table[(h + i) & (SIZE - 1)];
+				if (entry.key == key)
+					return entry.until <= now;
+				if (entry.key == 0)
+					break;
+			}
+			return true;
+		}
+
+		// Returns false if key is on cooldown, otherwise starts a new one
+		static bool try_fire(uint64_t key, double now, float cooldown)
+		{
+			std::lock_guard guard(lock);
+
+			uint32_t h = hash(key);
+			Entry* free = nullptr;
+			for (uint32_t i = 0; i < MAX_PROBES; i++) {
+				auto& entry = table[(h + i) & (SIZE - 1)];
+				if (entry.key == key) {
+					if (entry.until > now)
+						return false;
+
+					entry.until = now + cooldown;
+					return true;
+				}
+
+				if (entry.key == 0) {
+					if (!free)
+						free = &entry;
+					break;
+				}
+
+				// expired or the oldest one
+				if (!free || entry.until < free->until)
+					free = &entry;
+			}
+
+			*free = { key, now + cooldown };
+			return true;
+		}
+	};
+
 	struct Trigger
 	{
+		enum class CooldownScope : uint32_t
+		{
+			Global,
+			Caster,
+			Target,
+			Projectile
+		};
+
 	private:
 		std::vector<Condition> conditions;
 		TriggerFunctions::Functions functions;
+		uint32_t id;
+		CooldownScope cooldown_scope;
+		float cooldown;  // 0 for none
+
+		uint64_t cooldown_key(Data* data, RE::Projectile* proj) const
+		{
+			uint32_t refr_key = 0;
+			switch (cooldown_scope) {
+			case CooldownScope::Caster:
+				refr_key = data->shooter ? data->shooter->formID : 0;
+				break;
+			case CooldownScope::Target:
+				refr_key = data->target ? data->target->formID : 0;
+				break;
+			case CooldownScope::Projectile:
+				// formIDs of projectiles are reused soon, handles have an age
+				if (auto cur = proj ? proj : data->proj)
+					refr_key = cur->GetHandle().native_handle();
+				break;
+			case CooldownScope::Global:
+			default:
+				break;
+			}
+
+			return (static_cast<uint64_t>(id) << 32) | refr_key;
+		}
 
 		void call_functions(Data* data, RE::Projectile* proj, RE::Actor* targetOverride) const
 		{
@@ -190,9 +299,15 @@ namespace Triggers
 		}
 
 	public:
-		Trigger(const std::string& filename, const Json::Value& json_trigger) :
-			functions(filename, json_trigger["TriggerFunctions"])
+		Trigger(const std::string& filename, const Json::Value& json_trigger, uint32_t id) :
+			functions(filename, json_trigger["TriggerFunctions"]), id(id), cooldown_scope(CooldownScope::Global), cooldown(0)
 		{
+			if (json_trigger.isMember("cooldown")) {
+				auto& json_cooldown = json_trigger["cooldown"];
+				cooldown = JsonUtils::getFloat(json_cooldown, "time");
+				cooldown_scope = JsonUtils::mb_read_field<CooldownScope::Global>(json_cooldown, "scope");
+			}
+
 			if (json_trigger.isMember("conditions")) {
 				auto& json_conditions = json_trigger["conditions"];
 				for (size_t i = 0; i < json_conditions.size(); i++) {
@@ -205,16 +320,26 @@ namespace Triggers
 
 		void eval(Data* data, RE::Projectile* proj, RE::Actor* targetOverride) const
 		{
-			if (call_conditions(data))
-				call_functions(data, proj, targetOverride);
+			if (!call_conditions(data))
+				return;
+
+			if (cooldown > 0 && !Cooldowns::try_fire(cooldown_key(data, proj), Cooldowns::now(), cooldown))
+				return;
+
+			call_functions(data, proj, targetOverride);
 		}
 
-		bool should_disable_origin(Data* data) const { return call_conditions(data) && functions.should_disable_origin(); }
+		bool should_disable_origin(Data* data) const
+		{
+			return functions.should_disable_origin() && call_conditions(data) &&
+			       (cooldown == 0 || Cooldowns::is_ready(cooldown_key(data, nullptr), Cooldowns::now()));
+		}
 	};
 
 	class Triggers
 	{
 		static inline std::array<std::vector<Trigger>, (uint32_t)Event::Total> triggers;
+		static inline uint32_t triggers_count = 0;
 
 	public:
 		static void clear()
@@ -222,6 +347,8 @@ namespace Triggers
 			for (auto& cur_triggers : triggers) {
 				cur_triggers.clear();
 			}
+			triggers_count = 0;
+			Cooldowns::clear();
 		}
 
 		static void init(const std::string& filename, const Json::Value& json_triggers)
@@ -230,7 +357,7 @@ namespace Triggers
 				auto& trigger = json_triggers[(int)i];
 
 				auto type = JsonUtils::read_enum<Event>(trigger, "event");
-				triggers[(uint32_t)type].emplace_back(filename, trigger);
+				triggers[(uint32_t)type].emplace_back(filename, trigger, ++triggers_count);
 			}
 		}
 
@@ -241,6 +368,8 @@ namespace Triggers
 			}
 		}
 
+		static bool has(Event e) { return !triggers[(uint32_t)e].empty(); }
+
 		// Called on ProjAppeared
 		static bool should_disable_origin(Data* data)
 		{
@@ -253,7 +382,103 @@ namespace Triggers
 		}
 	};
 
-	void clear() { Triggers::clear(); }
+	// Collects impacts of the frame, calls ImpactBurst once per group
+	class Bursts
+	{
+		struct Key
+		{
+			RE::TESObjectWEAP* weap;
+			RE::BGSProjectile* bproj;
+			RE::MagicItem* spel;
+			RE::TESAmmo* ammo;
+			RE::FormID shooter;
+			RE::FormID target;
+
+			bool operator==(const Key&) const = default;
+		};
+
+		struct KeyHash
+		{
+			size_t operator()(const Key& key) const
+			{
+				size_t ans = std::hash<void*>()(key.bproj) ^ (std::hash<void*>()(key.spel) << 1) ^
+				             (std::hash<void*>()(key.weap) << 2) ^ (std::hash<void*>()(key.ammo) << 3);
+				return ans ^ ((static_cast<size_t>(key.shooter) << 32) | key.target);
+			}
+		};
+
+		struct Burst
+		{
+			Data data;
+			RE::ObjectRefHandle shooter;
+			RE::ObjectRefHandle target;
+			RE::NiPoint3 pos_sum;
+		};
+
+		static inline std::unordered_map<Key, uint32_t, KeyHash> inds;
+		static inline std::vector<Burst> bursts;
+		static inline std::mutex lock;
+
+	public:
+		static void add(const Data& data)
+		{
+			if (!Triggers::has(Event::ImpactBurst))
+				return;
+
+			Key key{ data.weap, data.bproj, data.spel, data.ammo, data.shooter ? data.shooter->formID : 0,
+				data.target ? data.target->formID : 0 };
+
+			std::lock_guard guard(lock);
+
+			auto [found, inserted] = inds.insert({ key, static_cast<uint32_t>(bursts.size()) });
+			if (inserted) {
+				auto& burst = bursts.emplace_back(data, data.shooter ? data.shooter->GetHandle() : RE::ObjectRefHandle(),
+					data.target ? data.target->GetHandle() : RE::ObjectRefHandle(), data.pos);
+				burst.data.hits = 1;
+			} else {
+				auto& burst = bursts[found->second];
+				burst.data.hits++;
+				burst.pos_sum += data.pos;
+			}
+		}
+
+		static void flush()
+		{
+			std::vector<Burst> cur;
+			{
+				std::lock_guard guard(lock);
+				if (bursts.empty())
+					return;
+
+				cur.swap(bursts);
+				inds.clear();
+			}
+
+			// Impacts without a shooter (traps, unloaded casters) are grouped under zero key
+			for (auto& burst : cur) {
+				auto shooter = burst.shooter.get();
+				auto target = burst.target.get();
+				burst.data.shooter = shooter.get();
+				burst.data.target = target.get();
+				burst.data.proj = nullptr;
+				burst.data.pos = burst.pos_sum / static_cast<float>(burst.data.hits);
+				eval(&burst.data, Event::ImpactBurst, nullptr);
+			}
+		}
+
+		static void clear()
+		{
+			std::lock_guard guard(lock);
+			bursts.clear();
+			inds.clear();
+		}
+	};
+
+	void clear()
+	{
+		Bursts::clear();
+		Triggers::clear();
+	}
 
 	void init(const std::string& filename, const Json::Value& json_root) { return Triggers::init(filename, json_root["Triggers"]); }
 
@@ -262,12 +487,18 @@ namespace Triggers
 		Triggers::eval(data, e, proj, targetOverride);
 	}
 
+	void update(float dtime)
+	{
+		Cooldowns::advance(dtime);
+		Bursts::flush();
+	}
+
 	namespace Hooks
 	{
 		class ApplyTriggersHook
 		{
 		public:
-			static void Hook()
+			static void HookLaunch()
 			{
 				auto& trmp = SKSE::GetTrampoline();
 
@@ -281,28 +512,42 @@ namespace Triggers
 				// SkyrimSE.exe+5504F5 -- MagicCaster::FireProjectile_0
 				_FireProjectile2 = trmp.write_call<5>(REL::ID(33671).address() + 0x125, FireProjectile2);
 
+				// 140550a37 MagicCaster::FireProjectile
+				_Launch1 = trmp.write_call<5>(REL::ID(33672).address() + 0x377, Launch1);
+
+				// 140550a37 TESObjectWEAP::Fire, the same call as LaunchArrow, so it goes after it
+				_Launch2 = trmp.write_call<5>(REL::ID(17693).address() + 0xe82, Launch2);
+			}
+
+			static void HookMelee()
+			{
+				auto& trmp = SKSE::GetTrampoline();
+
 				// 140628dd7 Actor::CombatHit
 				_InitializeHitData = trmp.write_call<5>(REL::ID(37673).address() + 0x1b7, InitializeHitData);
 
 				// 1407211ea HitFrameHandler::Handle
 				_DoMeleeAttack = trmp.write_call<5>(REL::ID(41747).address() + 0x3a, DoMeleeAttack);
-				
+			}
+
+			static void HookEffects()
+			{
 				_EffectAddedC = REL::Relocation<uintptr_t>(RE::VTABLE_Character[4]).write_vfunc(0x8, EffectAddedC);
 				_EffectAddedP = REL::Relocation<uintptr_t>(RE::VTABLE_PlayerCharacter[4]).write_vfunc(0x8, EffectAddedP);
 				_EffectRemovedC = REL::Relocation<uintptr_t>(RE::VTABLE_Character[4]).write_vfunc(0x9, EffectRemovedC);
 				_EffectRemovedP = REL::Relocation<uintptr_t>(RE::VTABLE_PlayerCharacter[4]).write_vfunc(0x9, EffectRemovedP);
+			}
 
-				// 140550a37 MagicCaster::FireProjectile
-				_Launch1 = trmp.write_call<5>(REL::ID(33672).address() + 0x377, Launch1);
-
-				// 140550a37 TESObjectWEAP::Fire
-				_Launch2 = trmp.write_call<5>(REL::ID(17693).address() + 0xe82, Launch2);
-
+			static void HookPreInit()
+			{
 				// SkyrimSE.exe+754bd8
-				_CalcVelocityVector = trmp.write_call<5>(REL::ID(43030).address() + 0x3b8, CalcVelocityVector);
+				_CalcVelocityVector =
+					SKSE::GetTrampoline().write_call<5>(REL::ID(43030).address() + 0x3b8, CalcVelocityVector);
+			}
 
-				// SkyrimSE.exe+74bc21 Proj::Kill
-				_ClearFollowedObject = trmp.write_call<5>(REL::ID(42930).address() + 0x21, ClearFollowedObject);
+			static void HookImpacts()
+			{
+				auto& trmp = SKSE::GetTrampoline();
 
 				// SkyrimSE.exe+7478cc MissileProj::AddImpact
 				_AddImpact1 = trmp.write_call<5>(REL::ID(42866).address() + 0xbc, AddImpact1);
@@ -364,6 +609,7 @@ namespace Triggers
 
 				Data data(Data::Type::Spell, ldata);
 				if (auto proj = handle->get().get()) {
+					data.proj = proj;
 					eval(&data, Event::ProjAppeared, proj);
 				}
 
@@ -375,6 +621,7 @@ namespace Triggers
 
 				Data data(Data::Type::Arrow, ldata);
 				if (auto proj = handle->get().get()) {
+					data.proj = proj;
 					eval(&data, Event::ProjAppeared, proj);
 				}
 
@@ -390,6 +637,7 @@ namespace Triggers
 					nullptr, left ? RE::MagicSystem::CastingSource::kLeftHand : RE::MagicSystem::CastingSource::kRightHand,
 					Data::Type::None, FenixUtils::Geom::rot_at(hitdata->hitDirection), hitdata->hitPosition);
 
+				data.target = victim;
 				eval(&data, Event::HitMelee, nullptr);
 				data.shooter = victim;
 				eval(&data, Event::HitByMelee, nullptr);
@@ -442,6 +690,7 @@ namespace Triggers
 			static void EffectAddedP(RE::MagicTarget* _this, RE::ActiveEffect* a_effect)
 			{
 				_EffectAddedP(_this, a_effect);
+				Cache::Keywords::invalidate((RE::Actor*)((char*)_this - 0x98));
 				if (a_effect) {
 					EffectAdded(_this, a_effect);
 				}
@@ -450,6 +699,7 @@ namespace Triggers
 			static void EffectAddedC(RE::MagicTarget* _this, RE::ActiveEffect* a_effect)
 			{
 				_EffectAddedC(_this, a_effect);
+				Cache::Keywords::invalidate((RE::Actor*)((char*)_this - 0x98));
 				if (a_effect) {
 					EffectAdded(_this, a_effect);
 				}
@@ -474,6 +724,7 @@ namespace Triggers
 					EffectRemoved(_this, a_effect);
 				}
 				_EffectRemovedP(_this, a_effect);
+				Cache::Keywords::invalidate((RE::Actor*)((char*)_this - 0x98));
 			}
 
 			static void EffectRemovedC(RE::MagicTarget* _this, RE::ActiveEffect* a_effect)
@@ -482,40 +733,24 @@ namespace Triggers
 					EffectRemoved(_this, a_effect);
 				}
 				_EffectRemovedC(_this, a_effect);
+				Cache::Keywords::invalidate((RE::Actor*)((char*)_this - 0x98));
 			}
 
+			// Applies ChangeSpeed and SetColLayer made before the projectile was inited
 			static void CalcVelocityVector(RE::Projectile* proj)
 			{
-				if (proj->linearVelocity.x != 0 || proj->linearVelocity.y != 0 || proj->linearVelocity.z != 0) {
-					if (proj->linearVelocity.x != 0) {
-						RE::COL_LAYER layer = RE::COL_LAYER::kSpell;
-						memcpy(&layer, &proj->linearVelocity.x, 4);
-						FenixUtils::Projectile__set_collision_layer(proj, layer);
-					}
-
-					// if both 0, then it is Add 0, so fine if it is skipped
-					if (proj->linearVelocity.y != 0 || proj->linearVelocity.z != 0) {
-						TriggerFunctions::Function changeVel(proj->linearVelocity);
-						_CalcVelocityVector(proj);
-						Data data(proj);
-						changeVel.eval(&data, proj);
-					} else {
-						_CalcVelocityVector(proj);
-					}
+				auto pending = take_pending_init(proj);
 
-				} else {
-					_CalcVelocityVector(proj);
-				}
-			}
+				if (pending.layer)
+					FenixUtils::Projectile__set_collision_layer(proj, pending.col_layer);
 
-			static void ClearFollowedObject(RE::BSSoundHandle* shandle)
-			{
-				auto proj = (RE::Projectile*)((char*)shandle - 0x128);
+				_CalcVelocityVector(proj);
 
-				Data data(proj);
-				eval(&data, Event::ProjDestroyed, nullptr);
-
-				_ClearFollowedObject(shandle);
+				if (pending.speed) {
+					float speed = proj->linearVelocity.Length();
+					if (speed > 0)
+						proj->linearVelocity *= (speed * pending.speed_mul + pending.speed_add) / speed;
+				}
 			}
 
 			static RE::Projectile::ImpactData* OnAddImpact(RE::Projectile* proj, RE::Projectile::ImpactData* ans)
@@ -524,10 +759,13 @@ namespace Triggers
 					Data data(proj);
 					data.pos = ans->desiredTargetLoc;
 					data.rot = FenixUtils::Geom::rot_at(-ans->negativeVelocity);
+					auto target = ans->collidee.get();
+					data.target = target.get();
 					eval(&data, Event::ProjImpact, nullptr);
-					if (auto target = ans->collidee.get().get(); target && target->As<RE::Actor>()) {
+					Bursts::add(data);
+					if (target && target->As<RE::Actor>()) {
 						eval(&data, Event::HitProjectile, nullptr);
-						data.shooter = target;
+						data.shooter = target.get();
 						eval(&data, Event::HitByProjectile, nullptr);
 					}
 				}
@@ -569,7 +807,6 @@ namespace Triggers
 			static inline REL::Relocation<decltype(AddImpact3)> _AddImpact3;
 			static inline REL::Relocation<decltype(AddImpact4)> _AddImpact4;
 			static inline REL::Relocation<decltype(AddImpact5)> _AddImpact5;
-			static inline REL::Relocation<decltype(ClearFollowedObject)> _ClearFollowedObject;
 			static inline REL::Relocation<decltype(CalcVelocityVector)> _CalcVelocityVector;
 			static inline REL::Relocation<decltype(InitializeHitData)> _InitializeHitData;
 			static inline REL::Relocation<decltype(DoMeleeAttack)> _DoMeleeAttack;
@@ -585,10 +822,15 @@ namespace Triggers
 		};
 	}
 
-	void install()
+	void on_destroyed(RE::Projectile* proj)
 	{
-		using namespace Hooks;
-
-		ApplyTriggersHook::Hook();
+		Data data(proj);
+		eval(&data, Event::ProjDestroyed, nullptr);
 	}
+
+	void install_launch() { Hooks::ApplyTriggersHook::HookLaunch(); }
+	void install_melee() { Hooks::ApplyTriggersHook::HookMelee(); }
+	void install_effects() { Hooks::ApplyTriggersHook::HookEffects(); }
+	void install_impacts() { Hooks::ApplyTriggersHook::HookImpacts(); }
+	void install_pre_init() { Hooks::ApplyTriggersHook::HookPreInit(); }
 }
@@ -17,6 +17,7 @@ namespace Triggers
 		EffectEnd,
 		ProjDestroyed,
 		ProjImpact,
+		ImpactBurst,  // impacts of a frame with same forms, caster and target
 
 		Total  // for std::array
 	};
@@ -41,6 +42,10 @@ namespace Triggers
 		RE::Projectile::ProjectileRot rot;
 		RE::NiPoint3 pos;
 
+		RE::TESObjectREFR* target = nullptr;  // hit target, if any
+		RE::Projectile* proj = nullptr;       // projectile the event is about, if any
+		uint32_t hits = 1;                    // number of impacts for ImpactBurst
+
 		Data(Type type, RE::Projectile::LaunchData* ldata) :
 			weap(ldata->weaponSource), shooter(ldata->shooter), bproj(ldata->projectileBase), spel(ldata->spell),
 			mgef((ldata->spell && ldata->spell->As<RE::SpellItem>()) ? ldata->spell->GetAVEffect() : nullptr),
@@ -52,7 +57,7 @@ namespace Triggers
 			weap(proj->weaponSource), shooter(proj->shooter.get().get()), bproj(proj->GetProjectileBase()), spel(proj->spell),
 			mgef(proj->spell ? proj->spell->GetAVEffect() : nullptr), ammo(proj->ammoSource), hand(proj->castingSource),
 			type(proj->weaponSource ? Type::Arrow : (proj->spell ? Type::Spell : Type::None)),
-			rot({ proj->GetAngleX(), proj->GetAngleZ() }), pos(proj->GetPosition())
+			rot({ proj->GetAngleX(), proj->GetAngleZ() }), pos(proj->GetPosition()), proj(proj)
 		{}
 
 		Data(RE::TESObjectWEAP* weap, RE::TESObjectREFR* shooter, RE::BGSProjectile* bproj, RE::MagicItem* spel,
@@ -70,5 +75,16 @@ namespace Triggers
 	// targetOverride used only for Multicast::Evenly support
 	void eval(Data* data, Event e, RE::Projectile* proj, RE::Actor* targetOverride = nullptr);
 
-	void install();
+	// Called once per frame
+	void update(float dtime);
+
+	// From shared hooks, ProjDestroyed
+	void on_destroyed(RE::Projectile* proj);
+
+	// Hooks by groups, installed only if some config uses their events (see Analyzer::HookGroup)
+	void install_launch();
+	void install_melee();
+	void install_effects();
+	void install_impacts();
+	void install_pre_init();
 }
@@ -73,10 +73,15 @@ namespace Gui
 #include "json/json.h"
 #include <JsonUtils.h>
 #include "Triggers.h"
+#include "TriggerFunctions.h"
 #include "Multicast.h"
 #include "Homing.h"
 #include "Emitters.h"
 #include "Followers.h"
+#include "Cache.h"
+#include "RuntimeData.h"
+#include "Analyzer.h"
+#include "Serialization.h"
 
 #ifdef VALIDATE
 
@@ -185,7 +190,71 @@ bool validate_folder(const std::string& path)
 }
 #endif  // VALIDATE
 
-void read_json()
+using HookGroups = std::array<bool, static_cast<size_t>(Analyzer::HookGroup::Total)>;
+static HookGroups installed_hooks = {};
+
+// Hooks of features and events that configs use. Installed once at kDataLoaded, write_call is not safe in game
+void install_hooks(const Analyzer::Usage& usage)
+{
+	using Group = Analyzer::HookGroup;
+
+	for (auto group : Analyzer::get_hook_groups(usage)) {
+		auto& done = installed_hooks[static_cast<size_t>(group)];
+		if (done)
+			continue;
+
+		switch (group) {
+		case Group::Homing:
+			Homing::install();
+			break;
+		case Group::Followers:
+			Followers::install();
+			break;
+		case Group::Emitters:
+			Emitters::install();
+			break;
+		case Group::ApplyGravity:
+			Hooks::ApplyGravityHook::Hook();
+			break;
+		case Group::Kill:
+			Hooks::KillHook::Hook();
+			break;
+		case Group::Launch:
+			Triggers::install_launch();
+			break;
+		case Group::Melee:
+			Triggers::install_melee();
+			break;
+		case Group::Effects:
+			Triggers::install_effects();
+			break;
+		case Group::Impacts:
+			Triggers::install_impacts();
+			break;
+		case Group::PreInit:
+			Triggers::install_pre_init();
+			break;
+		default:
+			assert(false);
+			break;
+		}
+
+		done = true;
+		logger::info("Installed hooks: {}", Analyzer::get_name(group));
+	}
+}
+
+// Reloaded configs may need hooks that were not installed at start, they work after restart
+void check_hooks(const Analyzer::Usage& usage)
+{
+	for (auto group : Analyzer::get_hook_groups(usage)) {
+		if (!installed_hooks[static_cast<size_t>(group)])
+			logger::warn("Hooks {} are not installed, restart the game to use them", Analyzer::get_name(group));
+	}
+}
+
+// Returns what the configs use, to install their hooks
+Analyzer::Usage read_json()
 {
 #ifdef VALIDATE
 	before_all();
@@ -194,11 +263,12 @@ void read_json()
 
 	if (!valid) {
 		logger::error("Some jsons are invalid, skipping");
-		return;
+		return {};
 	}
 #endif
 
 	JsonUtils::FormIDsMap::clear();
+	Cache::clear();
 
 	Homing::clear();
 	Multicast::clear();
@@ -206,9 +276,11 @@ void read_json()
 	Followers::clear();
 
 	Triggers::clear();
+	TriggerFunctions::clear();
 
 	namespace fs = std::filesystem;
 
+	Analyzer::Files files;
 	for (const auto& entry : fs::directory_iterator("Data/HomingProjectiles")) {
 		Json::Value json_root;
 		std::ifstream ifs;
@@ -233,19 +305,27 @@ void read_json()
 			Followers::init(filename, json_root);
 
 			Triggers::init(filename, json_root);
+
+			files.emplace_back(filename, std::move(json_root));
 		}
 	}
 
+	for (const auto& line : Analyzer::analyze(files).format()) {
+		logger::info("{}", line);
+	}
+
 	// Used only while reading json
 	Homing::clear_keys();
 	Multicast::clear_keys();
 	Emitters::clear_keys();
 	Followers::clear_keys();
+
+	return Analyzer::get_usage(files);
 }
 
 void reset_json()
 {
-	read_json();
+	check_hooks(read_json());
 }
 
 class Settings : public SettingsBase
@@ -350,11 +430,56 @@ public:
 		static bool isPressed(int k) { return k == key && isPressed_adds(); }
 	};
 
+	// Max expensive work per frame, the rest is carried over. Off by default
+	class Budget
+	{
+	public:
+		static void load(const CSimpleIniA& ini)
+		{
+			auto cost = ini.GetLongValue("Budget", "frame_cost", 0);
+			auto ms = ini.GetDoubleValue("Budget", "frame_ms", 0.0);
+			TriggerFunctions::set_budget(static_cast<uint32_t>(std::max(cost, 0l)), static_cast<float>(ms));
+		}
+	};
+
+	// Limits of projectiles chains, launched by triggers
+	class Cascade
+	{
+	public:
+		static void load(const CSimpleIniA& ini)
+		{
+			auto depth = ini.GetLongValue("Cascade", "max_depth", 8);
+			auto descendants = ini.GetLongValue("Cascade", "max_descendants", 2000);
+			Multicast::set_cascade_limits(static_cast<uint32_t>(std::max(depth, 0l)),
+				static_cast<uint32_t>(std::max(descendants, 0l)));
+		}
+	};
+
+	// Followers of distant and unseen casters
+	class FollowersLOD
+	{
+	public:
+		static void load(const CSimpleIniA& ini)
+		{
+			Followers::LODSettings settings;
+			settings.enabled = ini.GetBoolValue("FollowersLOD", "enabled", true);
+			settings.near_dist = static_cast<float>(ini.GetDoubleValue("FollowersLOD", "near_dist", 2048.0));
+			settings.far_dist = static_cast<float>(ini.GetDoubleValue("FollowersLOD", "far_dist", 6144.0));
+			settings.mid_interval = static_cast<uint32_t>(std::max(ini.GetLongValue("FollowersLOD", "mid_interval", 2), 1l));
+			settings.far_interval = static_cast<uint32_t>(std::max(ini.GetLongValue("FollowersLOD", "far_interval", 4), 1l));
+			settings.snap_far = ini.GetBoolValue("FollowersLOD", "snap_far", true);
+			Followers::set_lod(settings);
+		}
+	};
+
 	static void load() {
 		CSimpleIniA ini;
 		ini.LoadFile(path);
 
 		ReloadHotkey::load(ini);
+		Budget::load(ini);
+		Cascade::load(ini);
+		FollowersLOD::load(ini);
 	}
 };
 
@@ -404,12 +529,10 @@ static void SKSEMessageHandler(SKSE::MessagingInterface::Message* message)
 	case SKSE::MessagingInterface::kDataLoaded:
 		Hooks::MultipleBeamsHook::Hook();
 		Hooks::NormLightingsHook::Hook();
-		Triggers::install();
-		Homing::install();
+		Hooks::UpdateHook::Hook();
 		Multicast::install();
-		Emitters::install();
-		Followers::install();
-		read_json();
+		Cache::install();
+		install_hooks(read_json());
 		InputHandler::GetSingleton()->enable();
 		Settings::load();
 
@@ -417,6 +540,15 @@ static void SKSEMessageHandler(SKSE::MessagingInterface::Message* message)
 		Gui::init();
 #endif  // WITH_IMGUI
 		break;
+
+	case SKSE::MessagingInterface::kNewGame:
+	case SKSE::MessagingInterface::kPostLoadGame:
+		Cache::reset();
+		Followers::reset();
+		Emitters::reset();
+		clear_extra_data();
+		Serialization::apply_loaded();
+		break;
 	}
 }
 
@@ -432,6 +564,7 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Load(const SKSE::LoadInterface* a_s
 
 	SKSE::Init(a_skse);
 	SKSE::AllocTrampoline(1 << 10);
+	Serialization::install();
 
 #ifdef WITH_DRAWING
 	DebugRenderUtils::UpdateHooks::Hook();
@@ -0,0 +1,69 @@
+#include "Analyzer.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// Usage: analyzer <configs dir> [--max-projectiles N] [--lifetime SECONDS]
+// Exit code is 1 if a cast may launch more than N projectiles, 2 on bad input.
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: analyzer <configs dir> [--max-projectiles N] [--lifetime SECONDS]\n";
+		return 2;
+	}
+
+	Analyzer::Settings settings;
+	double max_projectiles = -1;
+	for (int i = 2; i + 1 < argc; i += 2) {
+		std::string arg = argv[i];
+		if (arg == "--max-projectiles") {
+			max_projectiles = std::atof(argv[i + 1]);
+		} else if (arg == "--lifetime") {
+			settings.lifetime = static_cast<float>(std::atof(argv[i + 1]));
+		} else {
+			std::cerr << "Unknown option " << arg << "\n";
+			return 2;
+		}
+	}
+
+	namespace fs = std::filesystem;
+
+	std::error_code ec;
+	Analyzer::Files files;
+	for (const auto& entry : fs::directory_iterator(argv[1], ec)) {
+		const auto& path = entry.path();
+		if (path.extension() == ".json" && path.filename() != "schema.json") {
+			Json::Value json_root;
+			Json::CharReaderBuilder builder;
+			std::string errs;
+			std::ifstream ifs(path);
+			if (!Json::parseFromStream(builder, ifs, &json_root, &errs)) {
+				std::cerr << path.filename().string() << ": " << errs;
+				return 2;
+			}
+			files.emplace_back(path.filename().string(), std::move(json_root));
+		}
+	}
+	if (ec) {
+		std::cerr << argv[1] << ": " << ec.message() << "\n";
+		return 2;
+	}
+
+	auto report = Analyzer::analyze(files, settings);
+	for (const auto& line : report.format()) {
+		std::cout << line << "\n";
+	}
+
+	std::cout << "Hooks:";
+	for (auto group : Analyzer::get_hook_groups(Analyzer::get_usage(files))) {
+		std::cout << " " << Analyzer::get_name(group);
+	}
+	std::cout << "\n";
+
+	if (max_projectiles >= 0 && report.worst.projectiles > max_projectiles) {
+		std::cerr << "Rejected: a cast may launch more than " << max_projectiles << " projectiles\n";
+		return 1;
+	}
+	return 0;
+}
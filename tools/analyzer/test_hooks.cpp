@@ -0,0 +1,91 @@
+#include "Analyzer.h"
+#include <iostream>
+#include <memory>
+
+// Hook groups that get_hook_groups picks for configs. Exit code is the number of failed checks.
+namespace
+{
+	using Group = Analyzer::HookGroup;
+
+	int failed = 0;
+
+	Analyzer::Files make_files(const char* text)
+	{
+		Json::Value json_root;
+		Json::CharReaderBuilder builder;
+		std::string errs;
+		std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+		std::string str(text);
+		if (!reader->parse(str.data(), str.data() + str.size(), &json_root, &errs)) {
+			std::cerr << "Bad test json: " << errs << "\n";
+			failed++;
+		}
+
+		Analyzer::Files files;
+		files.emplace_back("test.json", std::move(json_root));
+		return files;
+	}
+
+	void check(const char* name, const char* text, std::vector<Group> expected)
+	{
+		auto groups = Analyzer::get_hook_groups(Analyzer::get_usage(make_files(text)));
+		if (groups == expected)
+			return;
+
+		failed++;
+		std::cerr << name << ": got";
+		for (auto group : groups) {
+			std::cerr << " " << Analyzer::get_name(group);
+		}
+		std::cerr << ", expected";
+		for (auto group : expected) {
+			std::cerr << " " << Analyzer::get_name(group);
+		}
+		std::cerr << "\n";
+	}
+}
+
+int main()
+{
+	check("empty", "{}", {});
+
+	check("homing", R"({ "HomingData": { "key": { "type": "ConstSpeed" } } })",
+		{ Group::Homing, Group::ApplyGravity, Group::Kill });
+
+	check("followers", R"({ "FollowersData": { "key": { "pattern": "Sphere" } } })",
+		{ Group::Followers, Group::ApplyGravity, Group::Kill });
+
+	check("emitters", R"({ "EmittersData": { "key": { "interval": 1.0, "functions": [] } } })",
+		{ Group::Emitters, Group::Kill });
+
+	check("destroyed", R"({ "Triggers": [ { "event": "ProjDestroyed" } ] })", { Group::Kill });
+
+	check("appeared", R"({ "Triggers": [ { "event": "ProjAppeared" } ] })", { Group::Launch });
+
+	check("melee", R"({ "Triggers": [ { "event": "HitByMelee" } ] })", { Group::Melee });
+
+	check("effects", R"({ "Triggers": [ { "event": "EffectEnd" } ] })", { Group::Effects });
+
+	check("caster keyword", R"({ "Triggers": [ { "event": "Swing", "conditions": [ { "type": "CasterHasKwd" } ] } ] })",
+		{ Group::Melee, Group::Effects });
+
+	check("impacts", R"({ "Triggers": [ { "event": "ImpactBurst" } ] })", { Group::Impacts });
+
+	check("pre init", R"({ "Triggers": [ { "event": "ProjAppeared", "TriggerFunctions": { "functions": [ { "type": "SetColLayer" } ] } } ] })",
+		{ Group::Launch, Group::PreInit });
+
+	check("multicast", R"({ "Triggers": [ { "event": "Cast", "TriggerFunctions": { "functions": [ { "type": "ApplyMultiCast" } ] } } ] })",
+		{ Group::Kill });
+
+	check("multicast functions", R"({ "MulticastData": { "key": [ { "TriggerFunctions": { "functions": [ { "type": "ChangeSpeed" } ] } } ] } })",
+		{ Group::PreInit });
+
+	check("emitter functions", R"({ "EmittersData": { "key": { "functions": [ { "TriggerFunctions": { "functions": [ { "type": "ChangeSpeed" } ] } } ] } } })",
+		{ Group::Emitters, Group::Kill, Group::PreInit });
+
+	check("unused", R"({ "Triggers": [ { "event": "Cast", "TriggerFunctions": { "functions": [ { "type": "SpawnSpell" } ] } } ] })", {});
+
+	if (failed == 0)
+		std::cout << "All checks passed\n";
+	return failed;
+}
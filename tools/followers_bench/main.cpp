@@ -0,0 +1,88 @@
+#include "RoundingBatch.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+// Usage: followers_bench [followers] [frames]
+// Followers orbit their slots at 60 fps, half of them Sphere, half Plane. Prints time of a frame,
+// exit code is 1 if some position is not finite.
+int main(int argc, char** argv)
+{
+	size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+	size_t frames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 600;
+	constexpr float DTIME = 1.0f / 60;
+	constexpr float SPEED = 600.0f;
+
+	using RoundingBatch::Vec;
+
+	struct Follower
+	{
+		Vec pos, vel, target;
+		float radius;
+		bool sphere;
+	};
+
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<float> coord(-1000.0f, 1000.0f);
+	std::uniform_real_distribution<float> rad(50.0f, 300.0f);
+
+	std::vector<Follower> followers(count);
+	for (size_t i = 0; i < count; i++) {
+		auto& f = followers[i];
+		f.target = { coord(rng) * 0.2f, coord(rng) * 0.2f, 100.0f };
+		f.pos = { coord(rng), coord(rng), coord(rng) };
+		Vec dir{ coord(rng), coord(rng), coord(rng) };
+		float len = std::sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+		f.vel = { dir.x / len * SPEED, dir.y / len * SPEED, dir.z / len * SPEED };
+		f.radius = rad(rng);
+		f.sphere = i % 2 == 0;
+	}
+
+	const Vec cast_dir{ 0.0f, 0.0f, 1.0f };
+	RoundingBatch::Arrays arrays;
+	arrays.reserve(count);
+
+	double total_ms = 0;
+	for (size_t frame = 0; frame < frames; frame++) {
+		auto start = std::chrono::steady_clock::now();
+
+		arrays.clear();
+		for (const auto& f : followers) {
+			arrays.add(f.pos, f.vel, f.target, cast_dir, f.radius, DTIME, f.sphere);
+		}
+		RoundingBatch::integrate(arrays);
+
+		total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// as MovePoint does: go to the next position, velocity looks there
+		for (size_t i = 0; i < count; i++) {
+			auto& f = followers[i];
+			auto next = arrays.get(i);
+			Vec d{ next.x - f.pos.x, next.y - f.pos.y, next.z - f.pos.z };
+			float len = std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+			if (len > 0)
+				f.vel = { d.x / len * SPEED, d.y / len * SPEED, d.z / len * SPEED };
+			f.pos = next;
+		}
+	}
+
+	size_t orbiting = 0;
+	for (const auto& f : followers) {
+		if (!std::isfinite(f.pos.x) || !std::isfinite(f.pos.y) || !std::isfinite(f.pos.z)) {
+			std::cerr << "Position is not finite\n";
+			return 1;
+		}
+
+		float dx = f.pos.x - f.target.x, dy = f.pos.y - f.target.y, dz = f.pos.z - f.target.z;
+		float dist = f.sphere ? std::sqrt(dx * dx + dy * dy + dz * dz) : std::sqrt(dx * dx + dy * dy);
+		if (std::abs(dist - f.radius) < f.radius * 0.05f && (f.sphere || std::abs(dz) < 1.0f))
+			orbiting++;
+	}
+
+	std::cout << count << " followers, " << frames << " frames: " << total_ms / frames << " ms per frame, "
+			  << total_ms * 1e6 / (static_cast<double>(frames) * count) << " ns per follower, " << orbiting
+			  << " orbiting their slots\n";
+	return 0;
+}